@@ -0,0 +1,37 @@
+# Writes the SPIR-V files in INPUTS ('|' separated) into OUTPUT as constexpr word arrays.
+# Usage: cmake -DOUTPUT=<header> -DINPUTS=<a.spv|b.spv> -P EmbedShaders.cmake
+
+string(REPLACE "|" ";" INPUTS "${INPUTS}")
+
+set(ARRAYS "")
+set(ENTRIES "")
+
+foreach(INPUT ${INPUTS})
+    # mesh.vert.spv -> mesh.vert / mesh_vert
+    get_filename_component(FILE_NAME ${INPUT} NAME)
+    string(REGEX REPLACE "\\.spv$" "" SHADER_NAME ${FILE_NAME})
+    string(MAKE_C_IDENTIFIER ${SHADER_NAME} SHADER_IDENTIFIER)
+
+    file(READ ${INPUT} CONTENT HEX)
+    string(LENGTH "${CONTENT}" LENGTH)
+    math(EXPR REMAINDER "${LENGTH} % 8")
+    if (LENGTH EQUAL 0 OR NOT REMAINDER EQUAL 0)
+        message(FATAL_ERROR "${INPUT} is not a valid SPIR-V binary")
+    endif()
+
+    # SPIR-V is a stream of little endian words
+    string(REGEX REPLACE "(..)(..)(..)(..)" "0x\\4\\3\\2\\1," WORDS "${CONTENT}")
+    set(WORD "0x........,")
+    string(REGEX REPLACE "(${WORD}${WORD}${WORD}${WORD}${WORD}${WORD}${WORD}${WORD})" "\\1\n        " WORDS "${WORDS}")
+    string(STRIP "${WORDS}" WORDS)
+
+    string(APPEND ARRAYS "    constexpr uint32_t ${SHADER_IDENTIFIER}[] = {\n        ${WORDS}\n    };\n\n")
+    string(APPEND ENTRIES "        {\"${SHADER_NAME}\", ${SHADER_IDENTIFIER}, sizeof(${SHADER_IDENTIFIER})},\n")
+endforeach()
+
+set(HEADER "// Generated by cmake/EmbedShaders.cmake, do not edit.\n#pragma once\n\nnamespace Engine::EmbeddedShaders {\n")
+string(APPEND HEADER "${ARRAYS}")
+string(APPEND HEADER "    struct Entry {\n        const char* name;\n        const uint32_t* code;\n        size_t size;\n    };\n\n")
+string(APPEND HEADER "    constexpr Entry entries[] = {\n${ENTRIES}    };\n}\n")
+
+file(WRITE ${OUTPUT} "${HEADER}")
@@ -0,0 +1,5 @@
+# Records the hash of the GLSL source a SPIR-V binary was compiled from, checked when configuring without glslc.
+# Usage: cmake -DSOURCE=<shader> -DOUTPUT=<shader.spv.sha256> -P HashShader.cmake
+
+file(SHA256 ${SOURCE} HASH)
+file(WRITE ${OUTPUT} "${HASH}\n")
@@ -5,10 +5,16 @@
 #include <iostream>
 #include <sstream>
 #include <algorithm>
+#include <numeric>
 #include <functional>
 #include <memory>
 #include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <future>
 #include <utility>
+#include <tuple>
 #include <cstdlib>
 #include <cstddef>
 #include <filesystem>
@@ -1,12 +1,37 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout (constant_id = 0) const bool TEXTURED = true;
+layout (constant_id = 1) const bool VERTEX_COLOR = false;
 
 layout (location = 0) in vec3 fragColor;
 layout (location = 1) in vec2 fragTexCoord;
 
 layout (location = 0) out vec4 outColor;
 
-layout (set = 1, binding = 0) uniform sampler2D texSampler;
+struct Material {
+    vec4 baseColor;
+    uint albedo;
+};
+
+layout (set = 1, binding = 0) uniform sampler2D textures[];
+layout (set = 1, binding = 1) readonly buffer Materials {
+    Material materials[];
+};
+
+layout (push_constant) uniform Push {
+    mat4 model;
+    uint material;
+} push;
 
 void main() {
-    outColor = texture(texSampler, fragTexCoord);
+    Material material = materials[push.material];
+
+    outColor = material.baseColor;
+    if (TEXTURED) {
+        outColor *= texture(textures[material.albedo], fragTexCoord);
+    }
+    if (VERTEX_COLOR) {
+        outColor.rgb *= fragColor;
+    }
 }
\ No newline at end of file
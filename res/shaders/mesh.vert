@@ -1,5 +1,8 @@
 #version 450
 
+layout (constant_id = 0) const bool TEXTURED = true;
+layout (constant_id = 1) const bool VERTEX_COLOR = false;
+
 layout (location = 0) in vec3 position;
 layout (location = 1) in vec3 color;
 layout (location = 2) in vec3 normal;
@@ -15,10 +18,11 @@ layout (set = 0, binding = 0) uniform Ubo {
 
 layout (push_constant) uniform Push {
     mat4 model;
+    uint material;
 } push;
 
 void main() {
     gl_Position = ubo.perspective * push.model * vec4(position, 1.0);
-    fragColor = color;
-    fragTexCoord = uv;
+    fragColor = VERTEX_COLOR ? color : vec3(1.0);
+    fragTexCoord = TEXTURED ? uv : vec2(0.0);
 }
\ No newline at end of file
@@ -1,4 +1,4 @@
 for f in res/shaders/*.vert res/shaders/*.frag; do
     echo "Compiling: $f"
-    /usr/bin/glslc "$f" -o "${f%}.spv"
-done
\ No newline at end of file
+    /usr/bin/glslc "$f" -o "${f%}.spv" && sha256sum "$f" | cut -d ' ' -f 1 > "$f.spv.sha256"
+done
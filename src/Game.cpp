@@ -1,4 +1,5 @@
 #include "Game.hpp"
+#include "Profiler.hpp"
 
 #include "renderers/RendererSystemBase.hpp"
 #include "renderers/MeshRenderer.hpp"
@@ -7,13 +8,20 @@
 #include "systems/TransformSystem.hpp"
 
 #include "graphics/Renderer.hpp"
+#include "graphics/GpuProfiler.hpp"
+#include "graphics/RenderStats.hpp"
 #include "graphics/AllocatedBuffer.hpp"
 #include "graphics/Mesh.hpp"
+#include "graphics/MaterialTable.hpp"
 
 #include "components/Transform.hpp"
 #include "components/Model.hpp"
+#include "components/MeshMaterial.hpp"
+
+#include <chrono>
 
 using Engine::Game;
+using Engine::Profiler;
 
 Game::Game() {
     //glfwInit(); initialize in window ctor
@@ -21,63 +29,129 @@ Game::Game() {
 
 void Game::init() {
     // Create renders
-    renders.push_back(std::make_unique<MeshRenderer>(device, renderer));
+    renders.push_back(std::make_unique<MeshRenderer>(device, renderer, pipelineLibrary, assets));
 
     // Create systems
     systems.push_back(std::make_unique<TransformSystem>());
 
-    Mesh::Builder meshBuilder{};
-    meshBuilder.loadModel("models/cube.obj");
-    auto mesh = std::make_shared<Mesh>(device, meshBuilder);
+    // models and materials hold a reference to their asset until the component is destroyed
+    registry.on_destroy<Model>().connect<&Game::releaseModel>(*this);
+    registry.on_destroy<MeshMaterial>().connect<&Game::releaseMaterial>(*this);
+
+    auto albedo = assets.loadTexture("textures/texture.jpg");
+    auto material = assets.createMaterial({glm::vec4{1}, albedo});
+    // the material keeps its own reference to the texture
+    assets.release(albedo);
 
     auto entity = registry.create();
     registry.emplace<Transform>(entity, glm::translate(glm::mat4{1}, glm::vec3{5,5,5}));
-    registry.emplace<Model>(entity, mesh);
+    registry.emplace<Model>(entity, assets.loadMesh("models/cube.obj"));
+    registry.emplace<MeshMaterial>(entity, material);
 
     entity = registry.create();
     registry.emplace<Transform>(entity);
-    registry.emplace<Model>(entity, mesh);
+    registry.emplace<Model>(entity, assets.loadMesh("models/cube.obj"));
+    assets.acquire(material);
+    registry.emplace<MeshMaterial>(entity, material);
 }
 
 Game::~Game() {
     glfwTerminate();
 }
 
+void Game::releaseModel(entt::registry& registry, entt::entity entity) {
+    assets.release(registry.get<Model>(entity).mesh);
+}
+
+void Game::releaseMaterial(entt::registry& registry, entt::entity entity) {
+    assets.release(registry.get<MeshMaterial>(entity).material);
+}
+
+bool Game::isRunning(uint32_t frame) const {
+    // without a window nothing can ask to close, so headless runs render a fixed number of frames
+    if (!window)
+        return frame < settings.headlessFrames;
+    return !window->shouldClose();
+}
+
+void Game::writeFrame(const std::string& path) {
+    std::vector<uint8_t> pixels;
+    renderer.readFrame(pixels);
+
+    std::ofstream file{path, std::ios::binary | std::ios::trunc};
+    if (!file.is_open()) {
+        std::cerr << "failed to open frame file: " << path << std::endl;
+        return;
+    }
+
+    // binary PPM, the readback rows are BGRA
+    const auto& extent = settings.headlessExtent;
+    file << "P6\n" << extent.width << " " << extent.height << "\n255\n";
+    for (size_t i = 0; i + 3 < pixels.size(); i += 4) {
+        char rgb[3] = {static_cast<char>(pixels[i + 2]), static_cast<char>(pixels[i + 1]), static_cast<char>(pixels[i])};
+        file.write(rgb, sizeof(rgb));
+    }
+}
+
 void Game::run() {
-    float currentTime = static_cast<float>(glfwGetTime());
+    // glfwGetTime needs GLFW, which headless runs never initialize
+    const auto startTime = std::chrono::steady_clock::now();
+    auto getTime = [&startTime]() {
+        return std::chrono::duration<float>(std::chrono::steady_clock::now() - startTime).count();
+    };
+
+    float currentTime = getTime();
     float previousTime = currentTime;
+    float reportTime = currentTime;
+    float statsTime = currentTime;
 
     camera.setPosition(glm::vec3{0, 0, 5});
 
-    while (!window.shouldClose()) {
-        glfwPollEvents();
+    PROFILE_THREAD("main");
 
-        currentTime = static_cast<float>(glfwGetTime());
+    for (uint32_t frame = 0; isRunning(frame); frame++) {
+        PROFILE_SCOPE("frame");
+
+        currentTime = getTime();
         float deltaTime = currentTime - previousTime;
         previousTime = currentTime;
 
-        if (input.getKeyDown(GLFW_KEY_ESCAPE)) {
-            window.shouldClose(true);
-        }
+        if (window) {
+            glfwPollEvents();
 
-        if (input.getKeyDown(GLFW_KEY_TAB)) {
-            window.toggleCursor();
-        }
+            if (input->getKeyDown(GLFW_KEY_ESCAPE)) {
+                window->shouldClose(true);
+            }
 
-        camera.update(input, deltaTime);
+            if (input->getKeyDown(GLFW_KEY_TAB)) {
+                window->toggleCursor();
+            }
+
+#ifdef ENGINE_ENABLE_PROFILER
+            if (input->getKeyDown(GLFW_KEY_F12)) {
+                Profiler::writeTrace("trace.json");
+            }
+#endif
+
+            camera.update(*input, deltaTime);
+        }
 
         SceneInfo sceneInfo { deltaTime, camera, registry };
         for (const auto& s : systems) {
+            PROFILE_SCOPE(s->getName());
             s->update(sceneInfo);
         }
 
         if (auto frameIndex = renderer.beginFrame(); frameIndex != std::numeric_limits<uint32_t>::max()) {
-            renderer.beginSwapChainRenderPass(frameIndex);
+            // material changes reach this frame only now that its previous use has finished
+            assets.getMaterialTable().update(frameIndex);
 
             // update
             UniformBufferObject ubo{};
             ubo.perspective = camera.getViewProjection();
-            ubo.orthogonal = glm::ortho(0, window.getWidth(), 0, window.getHeight());
+            int width = window ? window->getWidth() : static_cast<int>(settings.headlessExtent.width);
+            int height = window ? window->getHeight() : static_cast<int>(settings.headlessExtent.height);
+            ubo.orthogonal = glm::ortho(0, width, 0, height);
             auto& buffer = renderer.getCurrentUniformBuffer();
             buffer->writeToBuffer(&ubo);
             buffer->flush();
@@ -86,21 +160,50 @@ void Game::run() {
                 frameIndex,
                 deltaTime,
                 camera,
-                registry
+                registry,
+                assets
             };
 
-            for (const auto& r : renders) {
-                r->render(frameInfo);
-            }
+            auto& profiler = renderer.getProfiler();
+            renderer.recordSwapChainRenderPass(frameIndex, [&](const vk::CommandBuffer& commandBuffer) {
+                for (const auto& r : renders) {
+                    PROFILE_SCOPE(r->getName());
+                    auto scope = profiler.beginScope(commandBuffer, r->getName());
+                    r->render(frameInfo);
+                    profiler.endScope(commandBuffer, scope);
+
+                    renderer.getStats().record(r->getName(), r->getStats());
+                    r->resetStats();
+                }
+            });
 
-            renderer.endSwapChainRenderPass(frameIndex);
             renderer.endFrame(frameIndex);
         }
 
-        input.reset();
+        if (settings.gpuProfilerLogInterval > 0 && currentTime - reportTime >= settings.gpuProfilerLogInterval) {
+            renderer.getProfiler().report(std::cout);
+            reportTime = currentTime;
+        }
+
+        if (settings.renderStatsLogInterval > 0 && currentTime - statsTime >= settings.renderStatsLogInterval) {
+            renderer.getStats().report(std::cout);
+            statsTime = currentTime;
+        }
+
+        if (input) {
+            input->reset();
+        }
     }
 
     device.getLogical().waitIdle();
+
+    if (renderer.isHeadless() && settings.readback) {
+        writeFrame("frame.ppm");
+    }
+
+#ifdef ENGINE_ENABLE_PROFILER
+    Profiler::writeTrace("trace.json");
+#endif
 }
 
 int main() {
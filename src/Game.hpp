@@ -6,7 +6,11 @@
 #include "graphics/SwapChain.hpp"
 #include "graphics/Pipeline.hpp"
 #include "graphics/Renderer.hpp"
+#include "graphics/RenderSettings.hpp"
 #include "graphics/Camera.hpp"
+#include "graphics/AssetRegistry.hpp"
+#include "graphics/PipelineCompiler.hpp"
+#include "graphics/PipelineLibrary.hpp"
 
 #define WIDTH 1280
 #define HEIGHT 720
@@ -32,11 +36,22 @@ namespace Engine {
             return instance;
         }
     private:
-        Window window{"Engine", WIDTH, HEIGHT};
-        Input input{window};
-        Device device{window};
-        Renderer renderer{window, device};
-        Camera camera{window, 5.0f, 45.0f, 0.1f, 100.0f};
+        void releaseModel(entt::registry& registry, entt::entity entity);
+        void releaseMaterial(entt::registry& registry, entt::entity entity);
+        bool isRunning(uint32_t frame) const;
+        void writeFrame(const std::string& path);
+
+        RenderSettings settings{RenderSettings::load("settings.cfg")};
+        //! Null when headless, GLFW is not initialized then.
+        std::unique_ptr<Window> window{settings.headless ? nullptr : std::make_unique<Window>("Engine", WIDTH, HEIGHT)};
+        std::unique_ptr<Input> input{window ? std::make_unique<Input>(*window) : nullptr};
+        // none of these can move, both branches construct in place
+        Device device = window ? Device{*window} : Device{};
+        Renderer renderer = window ? Renderer{*window, device, settings} : Renderer{device, settings.headlessExtent, settings};
+        Camera camera = window ? Camera{*window, 5.0f, 45.0f, 0.1f, 100.0f} : Camera{settings.headlessExtent, 5.0f, 45.0f, 0.1f, 100.0f};
+        AssetRegistry assets{device, renderer.getFramesInFlight()};
+        PipelineCompiler pipelineCompiler{device};
+        PipelineLibrary pipelineLibrary{device, pipelineCompiler};
         entt::registry registry;
 
         std::vector<std::unique_ptr<RendererSystemBase>> renders;
@@ -0,0 +1,102 @@
+#include "Profiler.hpp"
+
+#include <chrono>
+#include <iomanip>
+
+using Engine::Profiler;
+
+std::mutex Profiler::mutex;
+std::vector<std::unique_ptr<Profiler::ThreadBuffer>> Profiler::buffers;
+
+Profiler::Scope::~Scope() {
+    record(name, start, now());
+}
+
+uint64_t Profiler::now() {
+    static const auto epoch = std::chrono::steady_clock::now();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+}
+
+void Profiler::setThreadName(const char* name) {
+    getThreadBuffer().name.store(name, std::memory_order_relaxed);
+}
+
+Profiler::ThreadBuffer& Profiler::getThreadBuffer() {
+    thread_local ThreadBuffer* buffer = nullptr;
+
+    if (!buffer) {
+        std::lock_guard<std::mutex> lock{mutex};
+        auto created = std::make_unique<ThreadBuffer>();
+        created->id = static_cast<uint32_t>(buffers.size());
+        created->events.resize(EVENTS_PER_THREAD);
+        buffer = created.get();
+        buffers.push_back(std::move(created));
+    }
+
+    return *buffer;
+}
+
+void Profiler::record(const char* name, uint64_t start, uint64_t end) {
+    auto& buffer = getThreadBuffer();
+
+    // only this thread writes, the release store publishes the event to writeTrace
+    uint64_t head = buffer.head.load(std::memory_order_relaxed);
+    buffer.events[head % EVENTS_PER_THREAD] = {name, start, end};
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+bool Profiler::writeTrace(const std::string& path) {
+    std::ofstream file{path, std::ios::trunc};
+    if (!file.is_open()) {
+        std::cerr << "failed to open trace file: " << path << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock{mutex};
+
+    // timestamps are in microseconds
+    auto writeTime = [&file](uint64_t nanoseconds) {
+        file << nanoseconds / 1000 << '.' << std::setw(3) << std::setfill('0') << nanoseconds % 1000 << std::setfill(' ');
+    };
+
+    file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+
+    for (const auto& buffer : buffers) {
+        if (const char* name = buffer->name.load(std::memory_order_relaxed)) {
+            file << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer->id
+                 << ",\"args\":{\"name\":\"" << name << "\"}}";
+            first = false;
+        }
+
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        uint64_t begin = head > EVENTS_PER_THREAD ? head - EVENTS_PER_THREAD : 0;
+        std::vector<Event> events;
+        events.reserve(head - begin);
+        for (uint64_t i = begin; i < head; i++) {
+            events.push_back(buffer->events[i % EVENTS_PER_THREAD]);
+        }
+
+        uint64_t after = buffer->head.load(std::memory_order_acquire);
+        // the thread kept recording while copying, drop whatever it has overwritten or may be writing
+        size_t skip = after + 1 > begin + EVENTS_PER_THREAD ? static_cast<size_t>(std::min(after + 1 - EVENTS_PER_THREAD - begin, head - begin)) : 0;
+
+        for (size_t i = skip; i < events.size(); i++) {
+            const auto& event = events[i];
+            file << (first ? "" : ",") << "\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->id << ",\"ts\":";
+            writeTime(event.start);
+            file << ",\"dur\":";
+            writeTime(event.end - event.start);
+            file << "}";
+            first = false;
+        }
+    }
+
+    file << "\n]}\n";
+
+    if (!file) {
+        std::cerr << "failed to write trace file: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
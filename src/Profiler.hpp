@@ -0,0 +1,67 @@
+#pragma once
+
+//! Scoped CPU markers, compiled out unless the build sets ENGINE_ENABLE_PROFILER.
+//! Names must outlive the profiler, string literals or names returned by systems.
+#ifdef ENGINE_ENABLE_PROFILER
+#define ENGINE_PROFILE_CONCAT_IMPL(a, b) a##b
+#define ENGINE_PROFILE_CONCAT(a, b) ENGINE_PROFILE_CONCAT_IMPL(a, b)
+#define PROFILE_SCOPE(name) ::Engine::Profiler::Scope ENGINE_PROFILE_CONCAT(profileScope, __LINE__){name}
+#define PROFILE_THREAD(name) ::Engine::Profiler::setThreadName(name)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_THREAD(name)
+#endif
+
+namespace Engine {
+    /// @brief Records scoped CPU markers and exports them as a Chrome trace
+    /// Every thread writes into its own ring of the last EVENTS_PER_THREAD markers, without locks or allocations.
+    /// The mutex is only taken when a thread records its first marker and while a trace is written.
+    /// Open the written file in chrome://tracing or https://ui.perfetto.dev.
+    /// @link https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU
+    class Profiler {
+    public:
+        static constexpr size_t EVENTS_PER_THREAD = 1 << 16;
+
+        class Scope {
+        public:
+            explicit Scope(const char* name) : name{name}, start{now()} {}
+            ~Scope();
+            Scope(const Scope&) = delete;
+            Scope(Scope&&) = delete;
+            Scope& operator=(const Scope&) = delete;
+            Scope& operator=(Scope&&) = delete;
+
+        private:
+            const char* name;
+            uint64_t start;
+        };
+
+        //! Nanoseconds since the profiler was first used.
+        static uint64_t now();
+        static void setThreadName(const char* name);
+        //! Writes the markers every thread still holds as Chrome trace event JSON, false if the file cannot be written.
+        static bool writeTrace(const std::string& path);
+
+    private:
+        struct Event {
+            const char* name;
+            uint64_t start;
+            uint64_t end;
+        };
+
+        struct ThreadBuffer {
+            uint32_t id;
+            std::atomic<const char*> name{nullptr};
+            std::vector<Event> events;
+            //! Number of events ever written, the ring index is taken modulo its size.
+            std::atomic<uint64_t> head{0};
+        };
+
+        static ThreadBuffer& getThreadBuffer();
+        static void record(const char* name, uint64_t start, uint64_t end);
+
+        static std::mutex mutex;
+        //! Outlive their threads, so markers of finished workers still end up in the trace.
+        static std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    };
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "../graphics/Handle.hpp"
+
+namespace Engine {
+    //! Material of a \c Model, entities without one are drawn with the default white material.
+    struct MeshMaterial {
+        MaterialHandle material;
+    };
+}
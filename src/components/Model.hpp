@@ -1,9 +1,12 @@
 #pragma once
 
-namespace Engine {
-    class Mesh;
+#include "../graphics/Handle.hpp"
+#include "../graphics/Shaders.hpp"
 
+namespace Engine {
     struct Model {
-        std::shared_ptr<Mesh> mesh;
+        MeshHandle mesh;
+        //! Shader permutation used to draw the mesh.
+        ShaderFeatureFlags features{SHADER_FEATURE_TEXTURED};
     };
 }
@@ -2,6 +2,11 @@
 #include "Ray.hpp"
 #include "Sphere.hpp"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AABB_SSE2
+#include <emmintrin.h>
+#endif
+
 using Engine::AABB;
 
 AABB::AABB() : center{0}, extents{0} {
@@ -197,6 +202,42 @@ AABB AABB::transformed(const glm::mat4& transform) const {
     };
 }
 
+AABB AABB::calculateBoundingBox(const std::vector<glm::vec3>& points) {
+    return calculateBoundingBox(points.data(), points.size());
+}
+
+AABB AABB::calculateBoundingBox(const glm::vec3* points, size_t size, size_t stride) {
+    if (!size)
+        return {};
+
+    const auto* bytes = reinterpret_cast<const uint8_t*>(points);
+    const auto& last = *reinterpret_cast<const glm::vec3*>(bytes + (size - 1) * stride);
+
+#ifdef AABB_SSE2
+    // a full 4 float load past any point but the last one stays inside the array
+    __m128 min = _mm_setr_ps(last.x, last.y, last.z, 0);
+    __m128 max = min;
+    for (size_t i = 0; i + 1 < size; ++i) {
+        __m128 point = _mm_loadu_ps(reinterpret_cast<const float*>(bytes + i * stride));
+        min = _mm_min_ps(min, point);
+        max = _mm_max_ps(max, point);
+    }
+
+    alignas(16) float lower[4], upper[4];
+    _mm_store_ps(lower, min);
+    _mm_store_ps(upper, max);
+    return { glm::vec3{lower[0], lower[1], lower[2]}, glm::vec3{upper[0], upper[1], upper[2]} };
+#else
+    glm::vec3 min{last}, max{last};
+    for (size_t i = 0; i + 1 < size; ++i) {
+        const auto& point = *reinterpret_cast<const glm::vec3*>(bytes + i * stride);
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+    return { min, max };
+#endif
+}
+
 std::ostream& operator<<(std::ostream& o, const AABB& b) {
     return o << "(" << glm::to_string(b.getMin()) << ", " << glm::to_string(b.getMax()) << ")";
 }
\ No newline at end of file
@@ -53,6 +53,11 @@ namespace Engine {
         void transform(const glm::mat4& transform);
         //! Converts axis-aligned box to another coordinate space.
         AABB transformed(const glm::mat4& transform) const;
+
+        //! Generate \c axis-aligned box from the given sequence of \a points.
+        static AABB calculateBoundingBox(const std::vector<glm::vec3>& points);
+        //! Generate \c axis-aligned box from the given sequence of \a points, placed \a stride bytes apart.
+        static AABB calculateBoundingBox(const glm::vec3* points, size_t size, size_t stride = sizeof(glm::vec3));
     };
 }
 
@@ -2,8 +2,173 @@
 #include "AABB.hpp"
 #include "Ray.hpp"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SPHERE_SSE2
+#include <emmintrin.h>
+#endif
+
 using Engine::Sphere;
 
+namespace {
+    //! Points split into coordinate arrays, padded to a multiple of 4 with copies of the first point.
+    class PointCloud {
+    public:
+        PointCloud(const glm::vec3* points, size_t size, size_t stride) : size{(size + 3) & ~size_t{3}} {
+            const auto* bytes = reinterpret_cast<const uint8_t*>(points);
+            x.resize(this->size);
+            y.resize(this->size);
+            z.resize(this->size);
+            for (size_t i = 0; i < this->size; ++i) {
+                const auto& point = *reinterpret_cast<const glm::vec3*>(bytes + (i < size ? i : 0) * stride);
+                x[i] = point.x;
+                y[i] = point.y;
+                z[i] = point.z;
+            }
+        }
+
+        glm::vec3 operator[](size_t i) const { return {x[i], y[i], z[i]}; }
+
+        //! Finds the points with the smallest and the largest projection on \a direction.
+        void findExtremes(const glm::vec3& direction, size_t& minIndex, size_t& maxIndex) const {
+#ifdef SPHERE_SSE2
+            const __m128 dx = _mm_set1_ps(direction.x);
+            const __m128 dy = _mm_set1_ps(direction.y);
+            const __m128 dz = _mm_set1_ps(direction.z);
+            const __m128i step = _mm_set1_epi32(4);
+
+            __m128i index = _mm_setr_epi32(0, 1, 2, 3);
+            __m128 lower = _mm_set1_ps(std::numeric_limits<float>::max());
+            __m128 upper = _mm_set1_ps(std::numeric_limits<float>::lowest());
+            __m128i lowerIndex = _mm_setzero_si128();
+            __m128i upperIndex = _mm_setzero_si128();
+
+            for (size_t i = 0; i < size; i += 4) {
+                __m128 projection = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&x[i]), dx), _mm_mul_ps(_mm_loadu_ps(&y[i]), dy)), _mm_mul_ps(_mm_loadu_ps(&z[i]), dz));
+
+                __m128i less = _mm_castps_si128(_mm_cmplt_ps(projection, lower));
+                lower = _mm_min_ps(projection, lower);
+                lowerIndex = _mm_or_si128(_mm_and_si128(less, index), _mm_andnot_si128(less, lowerIndex));
+
+                __m128i greater = _mm_castps_si128(_mm_cmpgt_ps(projection, upper));
+                upper = _mm_max_ps(projection, upper);
+                upperIndex = _mm_or_si128(_mm_and_si128(greater, index), _mm_andnot_si128(greater, upperIndex));
+
+                index = _mm_add_epi32(index, step);
+            }
+
+            alignas(16) float lowerValues[4], upperValues[4];
+            alignas(16) int32_t lowerIndices[4], upperIndices[4];
+            _mm_store_ps(lowerValues, lower);
+            _mm_store_ps(upperValues, upper);
+            _mm_store_si128(reinterpret_cast<__m128i*>(lowerIndices), lowerIndex);
+            _mm_store_si128(reinterpret_cast<__m128i*>(upperIndices), upperIndex);
+
+            size_t minLane = 0, maxLane = 0;
+            for (size_t lane = 1; lane < 4; ++lane) {
+                if (lowerValues[lane] < lowerValues[minLane])
+                    minLane = lane;
+                if (upperValues[lane] > upperValues[maxLane])
+                    maxLane = lane;
+            }
+            minIndex = static_cast<size_t>(lowerIndices[minLane]);
+            maxIndex = static_cast<size_t>(upperIndices[maxLane]);
+#else
+            minIndex = maxIndex = 0;
+            float lower = glm::dot(direction, (*this)[0]);
+            float upper = lower;
+            for (size_t i = 1; i < size; ++i) {
+                float projection = direction.x * x[i] + direction.y * y[i] + direction.z * z[i];
+                if (projection < lower) {
+                    lower = projection;
+                    minIndex = i;
+                }
+                if (projection > upper) {
+                    upper = projection;
+                    maxIndex = i;
+                }
+            }
+#endif
+        }
+
+        //! Finds the point farthest from \a center, returns its index and squared \a distance.
+        size_t findFarthest(const glm::vec3& center, float& distance) const {
+#ifdef SPHERE_SSE2
+            const __m128 cx = _mm_set1_ps(center.x);
+            const __m128 cy = _mm_set1_ps(center.y);
+            const __m128 cz = _mm_set1_ps(center.z);
+            const __m128i step = _mm_set1_epi32(4);
+
+            __m128i index = _mm_setr_epi32(0, 1, 2, 3);
+            __m128 farthest = _mm_set1_ps(-1);
+            __m128i farthestIndex = _mm_setzero_si128();
+
+            for (size_t i = 0; i < size; i += 4) {
+                __m128 ox = _mm_sub_ps(_mm_loadu_ps(&x[i]), cx);
+                __m128 oy = _mm_sub_ps(_mm_loadu_ps(&y[i]), cy);
+                __m128 oz = _mm_sub_ps(_mm_loadu_ps(&z[i]), cz);
+                __m128 distance2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ox, ox), _mm_mul_ps(oy, oy)), _mm_mul_ps(oz, oz));
+
+                __m128i greater = _mm_castps_si128(_mm_cmpgt_ps(distance2, farthest));
+                farthest = _mm_max_ps(distance2, farthest);
+                farthestIndex = _mm_or_si128(_mm_and_si128(greater, index), _mm_andnot_si128(greater, farthestIndex));
+
+                index = _mm_add_epi32(index, step);
+            }
+
+            alignas(16) float values[4];
+            alignas(16) int32_t indices[4];
+            _mm_store_ps(values, farthest);
+            _mm_store_si128(reinterpret_cast<__m128i*>(indices), farthestIndex);
+
+            size_t lane = 0;
+            for (size_t i = 1; i < 4; ++i) {
+                if (values[i] > values[lane])
+                    lane = i;
+            }
+            distance = values[lane];
+            return static_cast<size_t>(indices[lane]);
+#else
+            size_t index = 0;
+            distance = -1;
+            for (size_t i = 0; i < size; ++i) {
+                float ox = x[i] - center.x, oy = y[i] - center.y, oz = z[i] - center.z;
+                float distance2 = ox * ox + oy * oy + oz * oz;
+                if (distance2 > distance) {
+                    distance = distance2;
+                    index = i;
+                }
+            }
+            return index;
+#endif
+        }
+
+        //! Moves and expands the sphere towards the farthest point until every point is inside.
+        void grow(glm::vec3& center, float& radius) const {
+            for (int step = 0;; ++step) {
+                float distance2;
+                glm::vec3 point = (*this)[findFarthest(center, distance2)];
+                float distance = std::sqrt(distance2);
+
+                // last pass already measured every point, so the radius is exact for this center
+                if (distance <= radius * 1.0001f || step == MAX_GROW_STEPS) {
+                    radius = std::max(radius, distance);
+                    return;
+                }
+
+                float newRadius = 0.5f * (radius + distance);
+                center += (newRadius - radius) / distance * (point - center);
+                radius = newRadius;
+            }
+        }
+
+        static constexpr int MAX_GROW_STEPS = 32;
+
+    private:
+        std::vector<float> x, y, z;
+        size_t size;
+    };
+}
+
 Sphere::Sphere() : center{0}, radius{0} {
 }
 
@@ -145,36 +310,45 @@ Sphere Sphere::calculateBoundingSphere(const std::vector<glm::vec3>& points) {
     return calculateBoundingSphere(points.data(), points.size());
 }
 
-Sphere Sphere::calculateBoundingSphere(const glm::vec3* points, size_t size) {
+Sphere Sphere::calculateBoundingSphere(const glm::vec3* points, size_t size, size_t stride) {
     if (!size)
         return {};
 
-    // compute minimal and maximal bounds
-    glm::vec3 min(points[0]), max(points[0]);
-    for (size_t i = 1; i < size; ++i) {
-        if (points[i].x < min.x)
-            min.x = points[i].x;
-        else if (points[i].x > max.x)
-            max.x = points[i].x;
-        if (points[i].y < min.y)
-            min.y = points[i].y;
-        else if (points[i].y > max.y)
-            max.y = points[i].y;
-        if (points[i].z < min.z)
-            min.z = points[i].z;
-        else if (points[i].z > max.z)
-            max.z = points[i].z;
+    PointCloud cloud{points, size, stride};
+
+    // most distant pair of extremal points along the axes and the box diagonals
+    static const glm::vec3 directions[] = {
+        {1, 0, 0}, {0, 1, 0}, {0, 0, 1},
+        {1, 1, 1}, {1, 1, -1}, {1, -1, 1}, {1, -1, -1}
+    };
+
+    glm::vec3 a{cloud[0]}, b{cloud[0]};
+    for (const auto& direction : directions) {
+        size_t minIndex, maxIndex;
+        cloud.findExtremes(direction, minIndex, maxIndex);
+        if (glm::distance2(cloud[minIndex], cloud[maxIndex]) > glm::distance2(a, b)) {
+            a = cloud[minIndex];
+            b = cloud[maxIndex];
+        }
     }
-    // compute center and radius
-    glm::vec3 center = 0.5f * (min + max);
-    float maxDistance = glm::distance2(center, points[0]);
-    for (size_t i = 1; i < size; ++i) {
-        float dist = glm::distance2(center, points[i]);
-        if (dist > maxDistance)
-            maxDistance = dist;
+
+    glm::vec3 center = 0.5f * (a + b);
+    float radius = 0.5f * glm::distance(a, b);
+    cloud.grow(center, radius);
+
+    // restart from a slightly smaller sphere and keep the tighter result (Ericson, Real-Time Collision Detection 4.3.4)
+    for (int i = 0; i < REFINE_ITERATIONS; ++i) {
+        glm::vec3 c{center};
+        float r = radius * 0.95f;
+        cloud.grow(c, r);
+        if (r >= radius)
+            break;
+
+        center = c;
+        radius = r;
     }
 
-    return { center, std::sqrt(maxDistance) };
+    return { center, radius };
 }
 
 std::ostream& operator<<(std::ostream& o, const Sphere& s) {
@@ -29,8 +29,9 @@ namespace Engine {
 
         //! Generate \c sphere from the given sequence of \a points.
         static Sphere calculateBoundingSphere(const std::vector<glm::vec3>& points);
-        //! Generate \c sphere from the given sequence of \a points.
-        static Sphere calculateBoundingSphere(const glm::vec3* points, size_t size);
+        //! Generate \c sphere from the given sequence of \a points, placed \a stride bytes apart.
+        //! Seeds the sphere with the most distant pair of extremal points and grows it towards the farthest point (near-minimal, within a few percent).
+        static Sphere calculateBoundingSphere(const glm::vec3* points, size_t size, size_t stride = sizeof(glm::vec3));
 
         //! Converts sphere to another coordinate system. Note that it will not return correct results if there are non-uniform scaling, shears, or other unusual transforms in \a transform.
         void transform(const glm::mat4& transform);
@@ -39,6 +40,7 @@ namespace Engine {
 
 
         static constexpr double EPSILON_VALUE = 4.37114e-05;
+        static constexpr int REFINE_ITERATIONS = 8;
     };
 }
 
@@ -22,8 +22,8 @@ AllocatedBuffer::AllocatedBuffer(
 
 AllocatedBuffer::~AllocatedBuffer() {
     unmap();
-    device.getLogical().destroyBuffer(buffer);
-    device.getLogical().freeMemory(memory);
+    device.getDeletionQueue().push(buffer);
+    device.getDeletionQueue().push(memory);
 }
 
 /**
@@ -0,0 +1,274 @@
+#include "AssetRegistry.hpp"
+#include "Mesh.hpp"
+#include "Texture.hpp"
+#include "MaterialTable.hpp"
+#include "../Profiler.hpp"
+
+using Engine::AssetRegistry;
+using Engine::Mesh;
+using Engine::Texture;
+using Engine::Material;
+using Engine::MeshHandle;
+using Engine::TextureHandle;
+using Engine::MaterialHandle;
+
+AssetRegistry::AssetRegistry(Device& device, uint32_t frameCount) : device{device} {
+    materialTable = std::make_unique<MaterialTable>(device, frameCount);
+}
+
+AssetRegistry::~AssetRegistry() {
+}
+
+MeshHandle AssetRegistry::loadMesh(const std::string& path) {
+    PROFILE_SCOPE("AssetRegistry::loadMesh");
+
+    std::string key = normalizePath(path);
+
+    uint64_t contentHash;
+    if (auto handle = meshes.find(key, 0, contentHash); handle.isValid())
+        return handle;
+
+    return importMesh(key, contentHash);
+}
+
+TextureHandle AssetRegistry::loadTexture(const std::string& path, vk::Format format) {
+    PROFILE_SCOPE("AssetRegistry::loadTexture");
+
+    std::string key = normalizePath(path);
+
+    uint64_t contentHash;
+    // the same file in another format is another texture
+    auto variant = static_cast<uint64_t>(format);
+    if (auto handle = textures.find(key, variant, contentHash); handle.isValid())
+        return handle;
+
+    auto handle = textures.emplace(key, variant, contentHash, device, key, format);
+    materialTable->setTexture(handle, *textures.pool.get(handle));
+    return handle;
+}
+
+MaterialHandle AssetRegistry::createMaterial(const Material& material) {
+    if (material.albedo.isValid()) {
+        acquire(material.albedo);
+    }
+
+    auto handle = materials.pool.emplace(material);
+    materials.records.emplace(handle.index, Record{{}, 0, 0, 1});
+    materialTable->setMaterial(handle, material);
+    return handle;
+}
+
+void AssetRegistry::acquire(MeshHandle handle) {
+    meshes.acquire(handle);
+}
+
+void AssetRegistry::acquire(TextureHandle handle) {
+    textures.acquire(handle);
+}
+
+void AssetRegistry::acquire(MaterialHandle handle) {
+    materials.acquire(handle);
+}
+
+void AssetRegistry::release(MeshHandle handle) {
+    meshes.release(handle);
+}
+
+void AssetRegistry::release(TextureHandle handle) {
+    textures.release(handle);
+}
+
+void AssetRegistry::release(MaterialHandle handle) {
+    materials.release(handle);
+}
+
+vk::DeviceSize AssetRegistry::unloadUnused() {
+    vk::DeviceSize freed = 0;
+
+    // materials first, they hold references to textures
+    std::vector<MaterialHandle> unusedMaterials;
+    materials.pool.each([&](MaterialHandle handle, const Material&) {
+        if (materials.records.at(handle.index).references == 0) {
+            unusedMaterials.push_back(handle);
+        }
+    });
+    for (auto handle : unusedMaterials) {
+        if (auto albedo = materials.pool.get(handle)->albedo; albedo.isValid()) {
+            release(albedo);
+        }
+        materialTable->removeMaterial(handle);
+        materials.erase(handle);
+    }
+
+    auto unload = [&](auto& cache) {
+        using Resource = typename std::decay_t<decltype(cache.pool)>::Resource;
+        std::vector<Handle<Resource>> unused;
+        cache.pool.each([&](Handle<Resource> handle, const Resource&) {
+            if (cache.records.at(handle.index).references == 0) {
+                unused.push_back(handle);
+            }
+        });
+        for (auto handle : unused) {
+            if constexpr (std::is_same_v<Resource, Texture>) {
+                materialTable->removeTexture(handle);
+            }
+            freed += cache.records.at(handle.index).memorySize;
+            cache.erase(handle);
+        }
+    };
+
+    unload(meshes);
+    unload(textures);
+
+    return freed;
+}
+
+vk::DeviceSize AssetRegistry::getMemoryUsage() const {
+    vk::DeviceSize size = 0;
+    for (const auto& [index, record] : meshes.records) {
+        size += record.memorySize;
+    }
+    for (const auto& [index, record] : textures.records) {
+        size += record.memorySize;
+    }
+    return size;
+}
+
+std::vector<AssetRegistry::AssetInfo> AssetRegistry::getAssets() const {
+    std::vector<AssetInfo> assets;
+    assets.reserve(meshes.records.size() + textures.records.size());
+    for (const auto& [index, record] : meshes.records) {
+        assets.push_back({record.path, record.contentHash, record.memorySize, record.references});
+    }
+    for (const auto& [index, record] : textures.records) {
+        assets.push_back({record.path, record.contentHash, record.memorySize, record.references});
+    }
+    return assets;
+}
+
+std::string AssetRegistry::normalizePath(const std::string& path) {
+    std::error_code error;
+    auto canonical = std::filesystem::weakly_canonical(path, error);
+    if (error) {
+        canonical = std::filesystem::absolute(path, error);
+    }
+    return canonical.lexically_normal().generic_string();
+}
+
+uint64_t AssetRegistry::hashFile(const std::string& path) {
+    std::ifstream file{path, std::ios::binary};
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open file: " + path);
+    }
+
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+    char buffer[64 * 1024];
+    while (file) {
+        file.read(buffer, sizeof(buffer));
+        for (std::streamsize i = 0; i < file.gcount(); ++i) {
+            hash ^= static_cast<uint8_t>(buffer[i]);
+            hash *= 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+MeshHandle AssetRegistry::importMesh(const std::string& path, uint64_t contentHash) {
+    PROFILE_SCOPE("AssetRegistry::importMesh");
+
+    std::filesystem::path source{path};
+
+    if (source.extension() == ".mesh") {
+        Mesh::Compressed compressed{};
+        compressed.load(path);
+        return meshes.emplace(path, 0, contentHash, device, compressed);
+    }
+
+    // imported models are cached in compressed form next to the source
+    auto cache = std::filesystem::path{source}.replace_extension(".mesh");
+    std::error_code error;
+    auto cacheTime = std::filesystem::last_write_time(cache, error);
+    if (!error && cacheTime >= std::filesystem::last_write_time(source)) {
+        try {
+            Mesh::Compressed compressed{};
+            compressed.load(cache.generic_string());
+            return meshes.emplace(path, 0, contentHash, device, compressed);
+        } catch (const std::runtime_error&) {
+            // outdated cache, import the source again
+        }
+    }
+
+    Mesh::Builder builder{};
+    builder.loadModel(path);
+    builder.generateLods();
+    builder.buildMeshlets();
+
+    // the cache only saves the import next time, e.g. read-only asset directories just go without
+    try {
+        builder.compress().save(cache.generic_string());
+    } catch (const std::runtime_error& e) {
+        std::cerr << "failed to cache mesh: " << e.what() << std::endl;
+    }
+
+    return meshes.emplace(path, 0, contentHash, device, builder);
+}
+
+template<typename T>
+Engine::Handle<T> AssetRegistry::Cache<T>::find(const std::string& path, uint64_t variant, uint64_t& contentHash) {
+    auto key = getKey(path, variant);
+    if (auto it = paths.find(key); it != paths.end()) {
+        acquire(it->second);
+        return it->second;
+    }
+
+    // same content under another path, register the alias
+    contentHash = hashFile(path) ^ (variant * 0x9E3779B97F4A7C15ull);
+    if (auto it = hashes.find(contentHash); it != hashes.end()) {
+        paths.emplace(key, it->second);
+        acquire(it->second);
+        return it->second;
+    }
+
+    return {};
+}
+
+template<typename T>
+template<typename... Args>
+Engine::Handle<T> AssetRegistry::Cache<T>::emplace(const std::string& path, uint64_t variant, uint64_t contentHash, Args&&... args) {
+    auto handle = pool.emplace(std::forward<Args>(args)...);
+    records.emplace(handle.index, Record{path, contentHash, pool.get(handle)->getMemorySize(), 1});
+    paths.emplace(getKey(path, variant), handle);
+    hashes.emplace(contentHash, handle);
+    return handle;
+}
+
+template<typename T>
+void AssetRegistry::Cache<T>::acquire(Handle<T> handle) {
+    assert(pool.contains(handle) && "Handle is stale");
+    records.at(handle.index).references++;
+}
+
+template<typename T>
+void AssetRegistry::Cache<T>::release(Handle<T> handle) {
+    assert(pool.contains(handle) && "Handle is stale");
+    auto& record = records.at(handle.index);
+    assert(record.references > 0 && "Asset is released more times than acquired");
+    record.references--;
+}
+
+template<typename T>
+void AssetRegistry::Cache<T>::erase(Handle<T> handle) {
+    for (auto it = paths.begin(); it != paths.end();) {
+        it = it->second == handle ? paths.erase(it) : std::next(it);
+    }
+    hashes.erase(records.at(handle.index).contentHash);
+    records.erase(handle.index);
+    pool.erase(handle);
+}
+
+template<typename T>
+std::string AssetRegistry::Cache<T>::getKey(const std::string& path, uint64_t variant) {
+    // paths cannot contain a null character, so this never collides with a real path
+    return variant == 0 ? path : path + '\0' + std::to_string(variant);
+}
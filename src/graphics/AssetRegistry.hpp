@@ -0,0 +1,103 @@
+#pragma once
+
+#include "ResourcePool.hpp"
+#include "Material.hpp"
+
+namespace Engine {
+    class Device;
+    class Mesh;
+    class Texture;
+    class MaterialTable;
+
+    /// @brief Owns meshes, textures and materials and hands out generational handles to them
+    /// Files are keyed by normalized path and by content hash, so repeated requests
+    /// (and copies of the same file under another name) share one loaded instance.
+    /// Textures are also keyed by format, a file loaded as sRGB and as UNORM gives two textures.
+    /// Every load or acquire adds a reference which has to be given back with release.
+    /// Not thread-safe: handles can be passed anywhere, but loading and unloading happen on the main thread.
+    class AssetRegistry {
+    public:
+        struct AssetInfo {
+            std::string path;
+            uint64_t contentHash;
+            vk::DeviceSize memorySize;
+            uint32_t references;
+        };
+
+        //! \a frameCount is the number of frames in flight, the material table keeps a copy per frame.
+        AssetRegistry(Device& device, uint32_t frameCount);
+        ~AssetRegistry();
+        AssetRegistry(const AssetRegistry&) = delete;
+        AssetRegistry(AssetRegistry&&) = delete;
+        AssetRegistry& operator=(const AssetRegistry&) = delete;
+        AssetRegistry& operator=(AssetRegistry&&) = delete;
+
+        //! Loads a mesh from an .obj (cached as .mesh next to it) or a compressed .mesh file.
+        MeshHandle loadMesh(const std::string& path);
+        TextureHandle loadTexture(const std::string& path, vk::Format format = vk::Format::eR8G8B8A8Srgb);
+        //! Registers \a material, which holds a reference to its textures.
+        MaterialHandle createMaterial(const Material& material);
+
+        void acquire(MeshHandle handle);
+        void acquire(TextureHandle handle);
+        void acquire(MaterialHandle handle);
+        void release(MeshHandle handle);
+        void release(TextureHandle handle);
+        void release(MaterialHandle handle);
+
+        Mesh* get(MeshHandle handle) const { return meshes.pool.get(handle); };
+        Texture* get(TextureHandle handle) const { return textures.pool.get(handle); };
+        Material* get(MaterialHandle handle) const { return materials.pool.get(handle); };
+
+        //! Bindless view of the loaded textures and materials.
+        MaterialTable& getMaterialTable() const { return *materialTable; };
+
+        //! Destroys every asset without references, returns the amount of freed memory.
+        vk::DeviceSize unloadUnused();
+
+        vk::DeviceSize getMemoryUsage() const;
+        std::vector<AssetInfo> getAssets() const;
+
+        static std::string normalizePath(const std::string& path);
+        static uint64_t hashFile(const std::string& path);
+
+    private:
+        struct Record {
+            std::string path;
+            uint64_t contentHash;
+            vk::DeviceSize memorySize;
+            uint32_t references;
+        };
+
+        template<typename T>
+        struct Cache {
+            ResourcePool<T> pool;
+            //! Slot index to the bookkeeping of the resource.
+            std::unordered_map<uint32_t, Record> records;
+            //! Normalized path (including aliases) and variant to the resource.
+            std::unordered_map<std::string, Handle<T>> paths;
+            //! Content hash mixed with the variant to the resource.
+            std::unordered_map<uint64_t, Handle<T>> hashes;
+
+            //! \a variant tells apart resources created differently from the same file, 0 if there is only one way.
+            Handle<T> find(const std::string& path, uint64_t variant, uint64_t& contentHash);
+            //! Constructs the resource from \a args in the pool.
+            template<typename... Args>
+            Handle<T> emplace(const std::string& path, uint64_t variant, uint64_t contentHash, Args&&... args);
+            void acquire(Handle<T> handle);
+            void release(Handle<T> handle);
+            void erase(Handle<T> handle);
+
+            static std::string getKey(const std::string& path, uint64_t variant);
+        };
+
+        //! Creates the mesh of \a path in the pool, from the .mesh cache when it is up to date.
+        MeshHandle importMesh(const std::string& path, uint64_t contentHash);
+
+        Device& device;
+        Cache<Mesh> meshes;
+        Cache<Texture> textures;
+        Cache<Material> materials;
+        std::unique_ptr<MaterialTable> materialTable;
+    };
+}
@@ -7,7 +7,20 @@ using Engine::Camera;
 using Engine::Ray;
 
 Camera::Camera(Window& window, float speed, float fov, float near, float far) :
-    window{window},
+    window{&window},
+    speed{speed},
+    fov{fov},
+    near{near},
+    far{far}
+{
+    assert(far > near && "Far cannot be less then near");
+    assert(speed >= 0.0f && "Speed cannot be negative");
+    updateViewMatrix();
+}
+
+Camera::Camera(vk::Extent2D extent, float speed, float fov, float near, float far) :
+    window{nullptr},
+    extent{extent},
     speed{speed},
     fov{fov},
     near{near},
@@ -71,8 +84,8 @@ void Camera::update(const Input& input, float deltaTime) {
         position -= right() * speed * deltaTime;
     }
 
-    if (window.isCursorLocked()) {
-        const glm::vec2& delta = input.mouseDelta() / (static_cast<float>(window.getHeight()) * 2);
+    if (window && window->isCursorLocked()) {
+        const glm::vec2& delta = input.mouseDelta() / (static_cast<float>(window->getHeight()) * 2);
         yaw += delta.x;
         pitch += delta.y;
 
@@ -90,16 +103,24 @@ void Camera::update(const Input& input, float deltaTime) {
     updateViewMatrix();
 }
 
+glm::vec2 Camera::getSize() const {
+    if (window)
+        return {window->getWidth(), window->getHeight()};
+    return {extent.width, extent.height};
+}
+
 void Camera::updateViewMatrix() {
     viewMatrix = glm::lookAt(position, position + forward(), up());
-    projectionMatrix = glm::perspective(fov, window.getAspect(), near, far);
+    float aspect = window ? window->getAspect() : static_cast<float>(extent.width) / static_cast<float>(extent.height);
+    projectionMatrix = glm::perspective(fov, aspect, near, far);
     viewProjectionMatrix = projectionMatrix * viewMatrix;
 }
 
 /// @link https://antongerdelan.net/opengl/raycasting.html
 Ray Camera::screenPointToRay(const glm::vec2& pos) const {
-    float mouseX = 2 * pos.x / static_cast<float>(window.getWidth() - 1);
-    float mouseY = 2 * pos.y / static_cast<float>(window.getHeight() - 1);
+    glm::vec2 size = getSize();
+    float mouseX = 2 * pos.x / (size.x - 1);
+    float mouseY = 2 * pos.y / (size.y - 1);
 #ifdef GLM_FORCE_DEPTH_ZERO_TO_ONE
     glm::vec4 screenPos(mouseX, -mouseY, 0, 1);
 #else
@@ -115,5 +136,5 @@ Ray Camera::screenPointToRay(const glm::vec2& pos) const {
 
 /// @link https://discourse.libcinder.org/t/screen-to-world-coordinates/1014/2
 glm::vec3 Camera::screenToWorldPoint(const glm::vec2& pos) const {
-    return glm::unProject(glm::vec3{pos, 0}, viewMatrix, projectionMatrix, window.getViewport());
+    return glm::unProject(glm::vec3{pos, 0}, viewMatrix, projectionMatrix, window ? window->getViewport() : glm::vec4{0, 0, getSize()});
 }
\ No newline at end of file
@@ -8,6 +8,8 @@ namespace Engine {
     class Camera {
     public:
         Camera(Window& window, float speed, float fov, float near, float far);
+        //! Camera of a headless renderer, projecting onto images of \a extent.
+        Camera(vk::Extent2D extent, float speed, float fov, float near, float far);
         ~Camera() = default;
         Camera(const Camera&) = delete;
         Camera(Camera&&) = delete;
@@ -53,8 +55,11 @@ namespace Engine {
         float far;
         float near;
 
-        Window& window;
+        //! Null when headless, the extent is used instead.
+        Window* window;
+        vk::Extent2D extent{};
 
+        glm::vec2 getSize() const;
         void updateViewMatrix();
     };
 }
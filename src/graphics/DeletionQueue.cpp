@@ -0,0 +1,140 @@
+#include "DeletionQueue.hpp"
+#include "Device.hpp"
+
+using Engine::DeletionQueue;
+
+DeletionQueue::DeletionQueue(Device& device) : device{device} {
+}
+
+DeletionQueue::~DeletionQueue() {
+}
+
+void DeletionQueue::push(vk::Buffer buffer) {
+    std::lock_guard<std::mutex> lock{mutex};
+    pending.buffers.push_back(buffer);
+}
+
+void DeletionQueue::push(vk::Image image) {
+    std::lock_guard<std::mutex> lock{mutex};
+    pending.images.push_back(image);
+}
+
+void DeletionQueue::push(vk::ImageView view) {
+    std::lock_guard<std::mutex> lock{mutex};
+    pending.views.push_back(view);
+}
+
+void DeletionQueue::push(vk::Sampler sampler) {
+    std::lock_guard<std::mutex> lock{mutex};
+    pending.samplers.push_back(sampler);
+}
+
+void DeletionQueue::push(vk::DeviceMemory memory) {
+    std::lock_guard<std::mutex> lock{mutex};
+    pending.memories.push_back(memory);
+}
+
+void DeletionQueue::push(vk::Framebuffer framebuffer) {
+    std::lock_guard<std::mutex> lock{mutex};
+    pending.framebuffers.push_back(framebuffer);
+}
+
+void DeletionQueue::push(vk::Pipeline pipeline) {
+    std::lock_guard<std::mutex> lock{mutex};
+    pending.pipelines.push_back(pipeline);
+}
+
+void DeletionQueue::push(vk::RenderPass renderPass) {
+    std::lock_guard<std::mutex> lock{mutex};
+    pending.renderPasses.push_back(renderPass);
+}
+
+void DeletionQueue::push(vk::Semaphore semaphore) {
+    std::lock_guard<std::mutex> lock{mutex};
+    pending.semaphores.push_back(semaphore);
+}
+
+void DeletionQueue::push(vk::SwapchainKHR swapChain) {
+    std::lock_guard<std::mutex> lock{mutex};
+    pending.swapChains.push_back(swapChain);
+}
+
+void DeletionQueue::retire(uint64_t timelineValue) {
+    std::lock_guard<std::mutex> lock{mutex};
+    assert((retired.empty() || retired.back().first <= timelineValue) && "Timeline values must increase");
+    if (pending.empty())
+        return;
+
+    retired.emplace_back(timelineValue, std::move(pending));
+    pending = Bucket{};
+}
+
+void DeletionQueue::collect(uint64_t completedValue) {
+    std::lock_guard<std::mutex> lock{mutex};
+    while (!retired.empty() && retired.front().first <= completedValue) {
+        flush(retired.front().second);
+        retired.pop_front();
+    }
+}
+
+void DeletionQueue::flushAll() {
+    std::lock_guard<std::mutex> lock{mutex};
+    for (auto& [value, bucket] : retired) {
+        flush(bucket);
+    }
+    retired.clear();
+    flush(pending);
+}
+
+void DeletionQueue::flush(Bucket& bucket) {
+    const auto& logical = device.getLogical();
+
+    // views and framebuffers go before the images, memory goes last
+    for (const auto& framebuffer : bucket.framebuffers) {
+        logical.destroyFramebuffer(framebuffer);
+    }
+    for (const auto& pipeline : bucket.pipelines) {
+        logical.destroyPipeline(pipeline);
+    }
+    for (const auto& view : bucket.views) {
+        logical.destroyImageView(view);
+    }
+    for (const auto& sampler : bucket.samplers) {
+        logical.destroySampler(sampler);
+    }
+    for (const auto& image : bucket.images) {
+        logical.destroyImage(image);
+    }
+    for (const auto& buffer : bucket.buffers) {
+        logical.destroyBuffer(buffer);
+    }
+    for (const auto& memory : bucket.memories) {
+        logical.freeMemory(memory);
+    }
+    for (const auto& renderPass : bucket.renderPasses) {
+        logical.destroyRenderPass(renderPass);
+    }
+    for (const auto& semaphore : bucket.semaphores) {
+        logical.destroySemaphore(semaphore);
+    }
+    // swap chain images are owned by the swap chain, their views are already gone
+    for (const auto& swapChain : bucket.swapChains) {
+        logical.destroySwapchainKHR(swapChain);
+    }
+
+    bucket.framebuffers.clear();
+    bucket.pipelines.clear();
+    bucket.views.clear();
+    bucket.samplers.clear();
+    bucket.images.clear();
+    bucket.buffers.clear();
+    bucket.memories.clear();
+    bucket.renderPasses.clear();
+    bucket.semaphores.clear();
+    bucket.swapChains.clear();
+}
+
+bool DeletionQueue::Bucket::empty() const {
+    return buffers.empty() && images.empty() && views.empty() && samplers.empty() && memories.empty() &&
+           framebuffers.empty() && pipelines.empty() && renderPasses.empty() && semaphores.empty() && swapChains.empty();
+}
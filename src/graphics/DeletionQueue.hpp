@@ -0,0 +1,59 @@
+#pragma once
+
+namespace Engine {
+    class Device;
+
+    /// @brief Defers destruction of Vulkan objects until no submitted work can use them
+    /// Objects are collected while a frame is recorded. When the frame is submitted they are tagged with its
+    /// timeline value, and destroyed once the device timeline semaphore has reached it.
+    class DeletionQueue {
+    public:
+        explicit DeletionQueue(Device& device);
+        ~DeletionQueue();
+        DeletionQueue(const DeletionQueue&) = delete;
+        DeletionQueue(DeletionQueue&&) = delete;
+        DeletionQueue& operator=(const DeletionQueue&) = delete;
+        DeletionQueue& operator=(DeletionQueue&&) = delete;
+
+        void push(vk::Buffer buffer);
+        void push(vk::Image image);
+        void push(vk::ImageView view);
+        void push(vk::Sampler sampler);
+        void push(vk::DeviceMemory memory);
+        void push(vk::Framebuffer framebuffer);
+        void push(vk::Pipeline pipeline);
+        void push(vk::RenderPass renderPass);
+        void push(vk::Semaphore semaphore);
+        void push(vk::SwapchainKHR swapChain);
+
+        //! Tags everything queued since the last submission with \a timelineValue, the value that submission signals.
+        void retire(uint64_t timelineValue);
+        //! Destroys everything retired with a value up to \a completedValue.
+        void collect(uint64_t completedValue);
+        //! Destroys everything. The device must be idle.
+        void flushAll();
+
+    private:
+        struct Bucket {
+            std::vector<vk::Buffer> buffers;
+            std::vector<vk::Image> images;
+            std::vector<vk::ImageView> views;
+            std::vector<vk::Sampler> samplers;
+            std::vector<vk::DeviceMemory> memories;
+            std::vector<vk::Framebuffer> framebuffers;
+            std::vector<vk::Pipeline> pipelines;
+            std::vector<vk::RenderPass> renderPasses;
+            std::vector<vk::Semaphore> semaphores;
+            std::vector<vk::SwapchainKHR> swapChains;
+
+            bool empty() const;
+        };
+
+        void flush(Bucket& bucket);
+
+        Device& device;
+        std::mutex mutex;
+        Bucket pending;
+        std::deque<std::pair<uint64_t, Bucket>> retired;
+    };
+}
@@ -4,6 +4,8 @@
 using Engine::DescriptorLayout;
 using Engine::DescriptorPool;
 using Engine::DescriptorWriter;
+using Engine::DescriptorAllocator;
+using Engine::DescriptorLayoutCache;
 
 // *************** Descriptor Pool Builder *********************
 
@@ -83,38 +85,145 @@ DescriptorLayout::Builder& DescriptorLayout::Builder::addBinding(uint32_t bindin
     return *this;
 }
 
+DescriptorLayout::Builder& DescriptorLayout::Builder::setBindingFlags(uint32_t binding, vk::DescriptorBindingFlags flags) {
+    assert(bindings.count(binding) == 1 && "Binding flags need an existing binding");
+    bindingFlags[binding] = flags;
+    return *this;
+}
+
+DescriptorLayout::Builder& DescriptorLayout::Builder::setCache(DescriptorLayoutCache& layoutCache) {
+    cache = &layoutCache;
+    return *this;
+}
+
+DescriptorLayout::Builder& DescriptorLayout::Builder::addTemplateEntry(uint32_t binding, size_t offset, size_t stride) {
+    assert(bindings.count(binding) == 1 && "Template entry needs an existing binding");
+    templateEntries.emplace_back(binding, offset, stride);
+    return *this;
+}
+
 std::unique_ptr<DescriptorLayout> DescriptorLayout::Builder::build() const {
+    // the cache keys on bindings only, it cannot tell layouts apart by their binding flags
+    assert((!cache || bindingFlags.empty()) && "Layouts with binding flags cannot be cached");
     return std::make_unique<DescriptorLayout>(*this);
 }
 
 // *************** Descriptor Set Layout *********************
 
-DescriptorLayout::DescriptorLayout(const Builder& builder) : device{builder.device}, bindings{builder.bindings} {
+DescriptorLayout::DescriptorLayout(const Builder& builder) : device{builder.device}, bindings{builder.bindings}, cached{builder.cache != nullptr} {
     std::vector<vk::DescriptorSetLayoutBinding> setLayoutBindings;
+    std::vector<vk::DescriptorBindingFlags> setLayoutBindingFlags;
     setLayoutBindings.reserve(bindings.size());
+    setLayoutBindingFlags.reserve(bindings.size());
+
+    vk::DescriptorSetLayoutCreateFlags layoutFlags;
 
     for (const auto& b : bindings) {
         setLayoutBindings.push_back(b.second);
+
+        auto it = builder.bindingFlags.find(b.first);
+        vk::DescriptorBindingFlags flags = it != builder.bindingFlags.end() ? it->second : vk::DescriptorBindingFlags();
+        if (flags & vk::DescriptorBindingFlagBits::eUpdateAfterBind) {
+            layoutFlags |= vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool;
+        }
+        setLayoutBindingFlags.push_back(flags);
     }
 
+    vk::DescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+    bindingFlagsInfo.bindingCount = static_cast<uint32_t>(setLayoutBindingFlags.size());
+    bindingFlagsInfo.pBindingFlags = setLayoutBindingFlags.data();
+
     vk::DescriptorSetLayoutCreateInfo descriptorSetLayoutInfo{};
+    descriptorSetLayoutInfo.flags = layoutFlags;
     descriptorSetLayoutInfo.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
     descriptorSetLayoutInfo.pBindings = setLayoutBindings.data();
+    if (!builder.bindingFlags.empty()) {
+        descriptorSetLayoutInfo.pNext = &bindingFlagsInfo;
+    }
+
+    if (cached) {
+        descriptorSetLayout = builder.cache->createDescriptorLayout(descriptorSetLayoutInfo);
+    } else {
+        try {
+            descriptorSetLayout = device.getLogical().createDescriptorSetLayout(descriptorSetLayoutInfo);
+        } catch (vk::SystemError& err) {
+            throw std::runtime_error("failed to create descriptor set layout!");
+        }
+    }
+
+    if (!builder.templateEntries.empty()) {
+        createUpdateTemplate(builder.templateEntries);
+    }
+}
+
+DescriptorLayout::~DescriptorLayout() {
+    if (updateTemplate) {
+        device.getLogical().destroyDescriptorUpdateTemplate(updateTemplate);
+    }
+    if (!cached) {
+        device.getLogical().destroyDescriptorSetLayout(descriptorSetLayout);
+    }
+}
+
+void DescriptorLayout::createUpdateTemplate(const std::vector<std::tuple<uint32_t, size_t, size_t>>& entries) {
+    std::vector<vk::DescriptorUpdateTemplateEntry> templateEntries;
+    templateEntries.reserve(entries.size());
+
+    for (const auto& [binding, offset, stride] : entries) {
+        const auto& bindingDescription = bindings[binding];
+
+        size_t infoSize;
+        switch (bindingDescription.descriptorType) {
+            case vk::DescriptorType::eSampler:
+            case vk::DescriptorType::eCombinedImageSampler:
+            case vk::DescriptorType::eSampledImage:
+            case vk::DescriptorType::eStorageImage:
+            case vk::DescriptorType::eInputAttachment:
+                infoSize = sizeof(vk::DescriptorImageInfo);
+                break;
+            case vk::DescriptorType::eUniformTexelBuffer:
+            case vk::DescriptorType::eStorageTexelBuffer:
+                infoSize = sizeof(vk::BufferView);
+                break;
+            default:
+                infoSize = sizeof(vk::DescriptorBufferInfo);
+                break;
+        }
+
+        vk::DescriptorUpdateTemplateEntry entry{};
+        entry.dstBinding = binding;
+        entry.dstArrayElement = 0;
+        entry.descriptorCount = bindingDescription.descriptorCount;
+        entry.descriptorType = bindingDescription.descriptorType;
+        entry.offset = offset;
+        entry.stride = stride != 0 ? stride : infoSize;
+        templateEntries.push_back(entry);
+    }
+
+    vk::DescriptorUpdateTemplateCreateInfo templateInfo{};
+    templateInfo.descriptorUpdateEntryCount = static_cast<uint32_t>(templateEntries.size());
+    templateInfo.pDescriptorUpdateEntries = templateEntries.data();
+    templateInfo.templateType = vk::DescriptorUpdateTemplateType::eDescriptorSet;
+    templateInfo.descriptorSetLayout = descriptorSetLayout;
 
     try {
-        descriptorSetLayout = device.getLogical().createDescriptorSetLayout(descriptorSetLayoutInfo);
+        updateTemplate = device.getLogical().createDescriptorUpdateTemplate(templateInfo);
     } catch (vk::SystemError& err) {
-        throw std::runtime_error("failed to create descriptor set layout!");
+        throw std::runtime_error("failed to create descriptor update template!");
     }
 }
 
-DescriptorLayout::~DescriptorLayout() {
-    device.getLogical().destroyDescriptorSetLayout(descriptorSetLayout);
+void DescriptorLayout::updateDescriptorSet(const vk::DescriptorSet& set, const void* data) const {
+    assert(updateTemplate && "Layout was built without template entries");
+    device.getLogical().updateDescriptorSetWithTemplate(set, updateTemplate, data);
 }
 
 // *************** Descriptor Writer *********************
 
-DescriptorWriter::DescriptorWriter(DescriptorLayout& layout, DescriptorPool& pool) : layout{layout}, pool{pool} {
+DescriptorWriter::DescriptorWriter(DescriptorLayout& layout, DescriptorPool& pool) : layout{layout}, pool{&pool} {
+}
+
+DescriptorWriter::DescriptorWriter(DescriptorLayout& layout, DescriptorAllocator& allocator) : layout{layout}, allocator{&allocator} {
 }
 
 DescriptorWriter& DescriptorWriter::writeBuffer(uint32_t binding, const vk::DescriptorBufferInfo& bufferInfo) {
@@ -148,7 +257,7 @@ DescriptorWriter& DescriptorWriter::writeImage(uint32_t binding, const vk::Descr
 }
 
 bool DescriptorWriter::build(vk::DescriptorSet& set) {
-    bool success = pool.allocateDescriptor(layout.getDescriptorSetLayout(), set);
+    bool success = allocate(set);
     if (!success) {
         return false;
     }
@@ -156,49 +265,64 @@ bool DescriptorWriter::build(vk::DescriptorSet& set) {
     return true;
 }
 
+bool DescriptorWriter::build(vk::DescriptorSet& set, const void* data) {
+    assert(writes.empty() && "Template updates cannot be mixed with individual writes");
+    bool success = allocate(set);
+    if (!success) {
+        return false;
+    }
+    layout.updateDescriptorSet(set, data);
+    return true;
+}
+
+bool DescriptorWriter::allocate(vk::DescriptorSet& set) {
+    if (pool) {
+        return pool->allocateDescriptor(layout.getDescriptorSetLayout(), set);
+    }
+    return allocator->allocateDescriptor(layout.getDescriptorSetLayout(), set);
+}
+
 void DescriptorWriter::overwrite(vk::DescriptorSet& set) {
     for (auto& write: writes) {
         write.dstSet = set;
     }
 
-    pool.device.getLogical().updateDescriptorSets(static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    layout.device.getLogical().updateDescriptorSets(static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
 }
 
-/*using Engine::DescriptorAllocator;
-using Engine::DescriptorLayoutCache;
-using Engine::DescriptorBuilder;
+// *************** Descriptor Allocator *********************
 
-DescriptorAllocator::DescriptorAllocator(Device& device) : device{device} {
+DescriptorAllocator::DescriptorAllocator(Device& device, uint32_t initialSets) : device{device}, setsPerPool{initialSets} {
 }
 
 DescriptorAllocator::~DescriptorAllocator() {
-    //delete every pool held
-    for (const auto& p : freePools) {
-        device.getLogical().destroyDescriptorPool(p);
+    for (const auto& pool : freePools) {
+        device.getLogical().destroyDescriptorPool(pool);
     }
-    for (const auto& p : usedPools) {
-        device.getLogical().destroyDescriptorPool(p);
+    for (const auto& pool : usedPools) {
+        device.getLogical().destroyDescriptorPool(pool);
     }
 }
 
 vk::DescriptorPool DescriptorAllocator::grabPool() {
     if (!freePools.empty()) {
-        //grab pool from the back of the vector and remove it from there.
         vk::DescriptorPool pool = freePools.back();
         freePools.pop_back();
         return pool;
-    } else {
-        //no pools availible, so create a new one
-        return createPool(1000, vk::DescriptorPoolCreateFlags());
     }
+
+    // every new pool is twice as large, so thousands of sets need only a handful of pools
+    vk::DescriptorPool pool = createPool(setsPerPool, vk::DescriptorPoolCreateFlags());
+    setsPerPool = std::min(setsPerPool * 2, MAX_SETS_PER_POOL);
+    return pool;
 }
 
 vk::DescriptorPool DescriptorAllocator::createPool(uint32_t count, vk::DescriptorPoolCreateFlags flags) const {
     std::vector<vk::DescriptorPoolSize> sizes;
     sizes.reserve(descriptorSizes.sizes.size());
 
-    for (auto sz : descriptorSizes.sizes) {
-        sizes.emplace_back(sz.first, static_cast<uint32_t>(sz.second * count));
+    for (const auto& [type, ratio] : descriptorSizes.sizes) {
+        sizes.emplace_back(type, std::max(static_cast<uint32_t>(ratio * static_cast<float>(count)), 1u));
     }
 
     vk::DescriptorPoolCreateInfo poolInfo{};
@@ -215,57 +339,48 @@ vk::DescriptorPool DescriptorAllocator::createPool(uint32_t count, vk::Descripto
 }
 
 bool DescriptorAllocator::allocateDescriptor(const vk::DescriptorSetLayout& layout, vk::DescriptorSet& set) {
-    //initialize the currentPool handle if it's null
     if (!currentPool) {
         currentPool = grabPool();
         usedPools.push_back(currentPool);
     }
 
     vk::DescriptorSetAllocateInfo allocInfo{};
-    allocInfo.pNext = nullptr;
     allocInfo.pSetLayouts = &layout;
     allocInfo.descriptorPool = currentPool;
     allocInfo.descriptorSetCount = 1;
 
-    //try to allocate the descriptor set
     auto result = device.getLogical().allocateDescriptorSets(&allocInfo, &set);
 
     switch (result) {
         case vk::Result::eSuccess:
-            //all good, return
             return true;
         case vk::Result::eErrorFragmentedPool:
         case vk::Result::eErrorOutOfPoolMemory:
-            //allocate a new pool and retry
+            // move on to the next pool and retry once
             currentPool = grabPool();
             usedPools.push_back(currentPool);
 
+            allocInfo.descriptorPool = currentPool;
             result = device.getLogical().allocateDescriptorSets(&allocInfo, &set);
-
-            //if it still fails then we have big issues
-            if (result == vk::Result::eSuccess){
+            if (result == vk::Result::eSuccess) {
                 return true;
             }
             break;
         default:
-            //unrecoverable error
-            return false;
+            break;
     }
 
+    std::cerr << "failed to allocate descriptor set: " << vk::to_string(result) << std::endl;
     return false;
 }
 
 void DescriptorAllocator::resetPools() {
-    //reset all used pools and add them to the free pools
-    for (const auto& p : usedPools) {
-        device.getLogical().resetDescriptorPool(p);
-        freePools.push_back(p);
+    for (const auto& pool : usedPools) {
+        device.getLogical().resetDescriptorPool(pool);
+        freePools.push_back(pool);
     }
 
-    //clear the used pools, since we've put them all in the free pools
     usedPools.clear();
-
-    //reset the current pool handle back to null
     currentPool = nullptr;
 }
 
@@ -273,188 +388,64 @@ void DescriptorAllocator::updateDescriptor(std::vector<vk::WriteDescriptorSet>&
     device.getLogical().updateDescriptorSets(static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
 }
 
+// *************** Descriptor Layout Cache *********************
+
 DescriptorLayoutCache::DescriptorLayoutCache(Device& device) : device{device} {
 }
 
 DescriptorLayoutCache::~DescriptorLayoutCache() {
-    //delete every descriptor layout held
     for (const auto& [info, layout] : layoutCache) {
         device.getLogical().destroyDescriptorSetLayout(layout);
     }
 }
 
-vk::DescriptorSetLayout DescriptorLayoutCache::createDescriptorLayout(vk::DescriptorSetLayoutCreateInfo& info) {
-    DescriptorLayoutInfo layoutinfo;
-    layoutinfo.bindings.reserve(info.bindingCount);
-    bool isSorted = true;
-    int32_t lastBinding = -1;
+vk::DescriptorSetLayout DescriptorLayoutCache::createDescriptorLayout(const vk::DescriptorSetLayoutCreateInfo& info) {
+    DescriptorLayoutInfo layoutInfo;
+    layoutInfo.flags = info.flags;
+    layoutInfo.bindings.assign(info.pBindings, info.pBindings + info.bindingCount);
 
-    //copy from the direct info struct into our own one
-    for (int i = 0; i < info.bindingCount; i++) {
-        layoutinfo.bindings.push_back(info.pBindings[i]);
+    // bindings are compared in order
+    std::sort(layoutInfo.bindings.begin(), layoutInfo.bindings.end(), [](const vk::DescriptorSetLayoutBinding& a, const vk::DescriptorSetLayoutBinding& b) {
+        return a.binding < b.binding;
+    });
 
-        //check that the bindings are in strict increasing order
-        int binding = static_cast<int32_t>(info.pBindings[i].binding);
-        if (binding > lastBinding) {
-            lastBinding = binding;
-        } else {
-            isSorted = false;
-        }
-    }
-    //sort the bindings if they aren't in order
-    if (!isSorted) {
-        std::sort(layoutinfo.bindings.begin(), layoutinfo.bindings.end(),
-              [](const vk::DescriptorSetLayoutBinding& a, const vk::DescriptorSetLayoutBinding& b) {
-                  return a.binding < b.binding;
-              });
+    if (auto it = layoutCache.find(layoutInfo); it != layoutCache.end()) {
+        return it->second;
     }
 
-    //try to grab from cache
-    auto it = layoutCache.find(layoutinfo);
-    if (it != layoutCache.end()) {
-        return (*it).second;
-    } else {
-        //create a new one (not found)
-        vk::DescriptorSetLayout layout;
-
-        try {
-            layout = device.getLogical().createDescriptorSetLayout(info);
-        } catch (vk::SystemError& err) {
-            throw std::runtime_error("failed to create descriptor set layout!");
-        }
-
-        //add to cache
-        layoutCache[layoutinfo] = layout;
-        return layout;
+    vk::DescriptorSetLayout layout;
+    try {
+        layout = device.getLogical().createDescriptorSetLayout(info);
+    } catch (vk::SystemError& err) {
+        throw std::runtime_error("failed to create descriptor set layout!");
     }
+
+    layoutCache.emplace(std::move(layoutInfo), layout);
+    return layout;
 }
 
-bool DescriptorLayoutCache::DescriptorLayoutInfo::operator==(const DescriptorLayoutInfo& other) const{
-    if (other.bindings.size() != bindings.size()){
+bool DescriptorLayoutCache::DescriptorLayoutInfo::operator==(const DescriptorLayoutInfo& other) const {
+    if (flags != other.flags || bindings.size() != other.bindings.size())
         return false;
-    } else {
-        //compare each of the bindings is the same. Bindings are sorted so they will match
-        for (int i = 0; i < bindings.size(); i++) {
-            if (other.bindings[i].binding != bindings[i].binding) {
-                return false;
-            }
-            if (other.bindings[i].descriptorType != bindings[i].descriptorType) {
-                return false;
-            }
-            if (other.bindings[i].descriptorCount != bindings[i].descriptorCount) {
-                return false;
-            }
-            if (other.bindings[i].stageFlags != bindings[i].stageFlags) {
-                return false;
-            }
+
+    for (size_t i = 0; i < bindings.size(); i++) {
+        const auto& a = bindings[i];
+        const auto& b = other.bindings[i];
+        if (a.binding != b.binding || a.descriptorType != b.descriptorType || a.descriptorCount != b.descriptorCount ||
+            a.stageFlags != b.stageFlags || a.pImmutableSamplers != b.pImmutableSamplers) {
+            return false;
         }
-        return true;
     }
+    return true;
 }
 
-size_t DescriptorLayoutCache::DescriptorLayoutInfo::hash() const{
+size_t DescriptorLayoutCache::DescriptorLayoutInfo::hash() const {
     size_t seed = std::hash<size_t>()(bindings.size());
+    hashCombine(seed, static_cast<uint32_t>(flags));
 
     for (const auto& b : bindings) {
-        //pack the binding data
         hashCombine(seed, b.binding, static_cast<uint32_t>(b.descriptorType), b.descriptorCount, static_cast<uint32_t>(b.stageFlags));
     }
 
     return seed;
 }
-
-DescriptorBuilder::DescriptorBuilder(DescriptorLayoutCache& cache, DescriptorAllocator& allocator) : cache{cache}, allocator{allocator} {
-}
-
-DescriptorBuilder::~DescriptorBuilder() {
-}
-
-DescriptorBuilder& DescriptorBuilder::bindBuffer(uint32_t binding, vk::DescriptorBufferInfo& bufferInfo, vk::DescriptorType type, vk::ShaderStageFlags stageFlags) {
-    //create the descriptor binding for the layout
-    vk::DescriptorSetLayoutBinding newBinding{};
-    newBinding.descriptorCount = 1;
-    newBinding.descriptorType = type;
-    newBinding.pImmutableSamplers = nullptr;
-    newBinding.stageFlags = stageFlags;
-    newBinding.binding = binding;
-
-    bindings.push_back(newBinding);
-
-    //create the descriptor write
-    vk::WriteDescriptorSet newWrite{};
-    newWrite.pNext = nullptr;
-    newWrite.descriptorCount = 1;
-    newWrite.descriptorType = type;
-    newWrite.pBufferInfo = &bufferInfo;
-    newWrite.dstBinding = binding;
-
-    writes.push_back(newWrite);
-    return *this;
-}
-
-DescriptorBuilder& DescriptorBuilder::bindImage(uint32_t binding, vk::DescriptorImageInfo& imageInfo, vk::DescriptorType type, vk::ShaderStageFlags stageFlags) {
-    //create the descriptor binding for the layout
-    vk::DescriptorSetLayoutBinding newBinding{};
-    newBinding.descriptorCount = 1;
-    newBinding.descriptorType = type;
-    newBinding.pImmutableSamplers = nullptr;
-    newBinding.stageFlags = stageFlags;
-    newBinding.binding = binding;
-
-    bindings.push_back(newBinding);
-
-    //create the descriptor write
-    vk::WriteDescriptorSet newWrite{};
-    newWrite.pNext = nullptr;
-    newWrite.descriptorCount = 1;
-    newWrite.descriptorType = type;
-    newWrite.pImageInfo = &imageInfo;
-    newWrite.dstBinding = binding;
-
-    writes.push_back(newWrite);
-    return *this;
-}
-
-bool DescriptorBuilder::build(vk::DescriptorSet& set, vk::DescriptorSetLayout& layout) {
-    //build layout first
-    vk::DescriptorSetLayoutCreateInfo layoutInfo{};
-    layoutInfo.pNext = nullptr;
-    layoutInfo.pBindings = bindings.data();
-    layoutInfo.bindingCount = bindings.size();
-
-    layout = cache.createDescriptorLayout(layoutInfo);
-
-    //allocate descriptor
-    bool success = allocator.allocateDescriptor(layout, set);
-    if (!success) return false;
-
-    //write descriptor
-    for (auto& w : writes) {
-        w.dstSet = set;
-    }
-
-    allocator.updateDescriptor(writes);
-    return true;
-}
-
-bool DescriptorBuilder::build(vk::DescriptorSet& set) {
-    //build layout first
-    vk::DescriptorSetLayoutCreateInfo layoutInfo{};
-    layoutInfo.pNext = nullptr;
-    layoutInfo.pBindings = bindings.data();
-    layoutInfo.bindingCount = bindings.size();
-
-    auto layout = cache.createDescriptorLayout(layoutInfo);
-
-    //allocate descriptor
-    bool success = allocator.allocateDescriptor(layout, set);
-    if (!success) return false;
-
-    //write descriptor
-    for (auto& w : writes) {
-        w.dstSet = set;
-    }
-
-    allocator.updateDescriptor(writes);
-    return true;
-}*/
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 namespace Engine {
     class Device;
+    class DescriptorAllocator;
+    class DescriptorLayoutCache;
 
     class DescriptorPool {
     public:
@@ -47,11 +49,20 @@ namespace Engine {
         public:
             explicit Builder(Device& device) : device{device} {}
             Builder& addBinding(uint32_t binding, vk::DescriptorType descriptorType, vk::ShaderStageFlags stageFlags, uint32_t count = 1);
+            //! Sets descriptor indexing flags of \a binding, update after bind also flags the layout.
+            Builder& setBindingFlags(uint32_t binding, vk::DescriptorBindingFlags flags);
+            //! Shares the layout through \a layoutCache, which then owns it.
+            Builder& setCache(DescriptorLayoutCache& layoutCache);
+            //! Adds \a binding to the update template, its infos start at \a offset of the packed struct. Zero \a stride packs them tightly.
+            Builder& addTemplateEntry(uint32_t binding, size_t offset, size_t stride = 0);
             std::unique_ptr<DescriptorLayout> build() const;
 
         private:
             Device& device;
+            DescriptorLayoutCache* cache{nullptr};
             std::unordered_map<uint32_t, vk::DescriptorSetLayoutBinding> bindings;
+            std::unordered_map<uint32_t, vk::DescriptorBindingFlags> bindingFlags;
+            std::vector<std::tuple<uint32_t, size_t, size_t>> templateEntries;
 
             friend class DescriptorLayout;
         };
@@ -64,11 +75,24 @@ namespace Engine {
         DescriptorLayout& operator=(DescriptorLayout&&) = delete;
 
         const vk::DescriptorSetLayout& getDescriptorSetLayout() const { return descriptorSetLayout; }
+        const vk::DescriptorUpdateTemplate& getUpdateTemplate() const { return updateTemplate; }
+
+        //! Writes every template entry of \a set from \a data in a single call, without building write structures.
+        void updateDescriptorSet(const vk::DescriptorSet& set, const void* data) const;
+        template<typename T>
+        void updateDescriptorSet(const vk::DescriptorSet& set, const T& data) const {
+            static_assert(std::is_trivially_copyable_v<T>, "Template data must be a packed POD struct");
+            updateDescriptorSet(set, static_cast<const void*>(&data));
+        }
 
     private:
+        void createUpdateTemplate(const std::vector<std::tuple<uint32_t, size_t, size_t>>& entries);
+
         Device& device;
         vk::DescriptorSetLayout descriptorSetLayout;
+        vk::DescriptorUpdateTemplate updateTemplate{nullptr};
         std::unordered_map<uint32_t, vk::DescriptorSetLayoutBinding> bindings;
+        bool cached;
 
         friend class DescriptorWriter;
     };
@@ -76,20 +100,31 @@ namespace Engine {
     class DescriptorWriter {
     public:
         DescriptorWriter(DescriptorLayout& layout, DescriptorPool& pool);
+        DescriptorWriter(DescriptorLayout& layout, DescriptorAllocator& allocator);
         DescriptorWriter& writeBuffer(uint32_t binding, const vk::DescriptorBufferInfo& bufferInfo);
         DescriptorWriter& writeImage(uint32_t binding, const vk::DescriptorImageInfo& imageInfo);
 
         bool build(vk::DescriptorSet& set);
         void overwrite(vk::DescriptorSet& set);
+        //! Allocates \a set and fills it through the update template of the layout.
+        bool build(vk::DescriptorSet& set, const void* data);
 
     private:
+        bool allocate(vk::DescriptorSet& set);
+
         DescriptorLayout& layout;
-        DescriptorPool& pool;
+        DescriptorPool* pool{nullptr};
+        DescriptorAllocator* allocator{nullptr};
         std::vector<vk::WriteDescriptorSet> writes;
     };
 
-    /*class DescriptorAllocator {
+    /// @brief Growable descriptor set allocator
+    /// Sets are allocated from a list of pools, a new and larger pool is grabbed whenever the current one runs out or fragments.
+    /// Resetting returns every pool at once, so per frame allocators can be recycled without freeing sets one by one.
+    /// @link https://vkguide.dev/docs/extra-chapter/abstracting_descriptors/
+    class DescriptorAllocator {
     public:
+        //! Descriptors of each type per set in a pool.
         struct PoolSizes {
             std::vector<std::pair<vk::DescriptorType, float>> sizes =
                 {
@@ -107,42 +142,51 @@ namespace Engine {
                 };
         };
 
-        DescriptorAllocator(Device& device);
+        explicit DescriptorAllocator(Device& device, uint32_t initialSets = 64);
         ~DescriptorAllocator();
         DescriptorAllocator(const DescriptorAllocator&) = delete;
         DescriptorAllocator(DescriptorAllocator&&) = delete;
         DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
         DescriptorAllocator& operator=(DescriptorAllocator&&) = delete;
 
-        vk::DescriptorPool grabPool();
-        void resetPools();
         bool allocateDescriptor(const vk::DescriptorSetLayout& layout, vk::DescriptorSet& set);
+        //! Recycles every pool, sets allocated so far become invalid.
+        void resetPools();
         void updateDescriptor(std::vector<vk::WriteDescriptorSet>& writes) const;
 
+        size_t getPoolCount() const { return usedPools.size() + freePools.size(); }
+
+        static constexpr uint32_t MAX_SETS_PER_POOL = 4096;
+
     private:
+        vk::DescriptorPool grabPool();
         vk::DescriptorPool createPool(uint32_t count, vk::DescriptorPoolCreateFlags flags) const;
 
+        Device& device;
         vk::DescriptorPool currentPool{nullptr};
         PoolSizes descriptorSizes;
         std::vector<vk::DescriptorPool> usedPools;
         std::vector<vk::DescriptorPool> freePools;
-
-        Device& device;
+        uint32_t setsPerPool;
     };
 
+    /// @brief Deduplicates descriptor set layouts by their sorted bindings
+    /// The cache owns every layout it returns, they are destroyed together with it.
     class DescriptorLayoutCache {
     public:
-        DescriptorLayoutCache(Device& device);
+        explicit DescriptorLayoutCache(Device& device);
         ~DescriptorLayoutCache();
         DescriptorLayoutCache(const DescriptorLayoutCache&) = delete;
         DescriptorLayoutCache(DescriptorLayoutCache&&) = delete;
         DescriptorLayoutCache& operator=(const DescriptorLayoutCache&) = delete;
         DescriptorLayoutCache& operator=(DescriptorLayoutCache&&) = delete;
 
-        vk::DescriptorSetLayout createDescriptorLayout(vk::DescriptorSetLayoutCreateInfo& info);
+        vk::DescriptorSetLayout createDescriptorLayout(const vk::DescriptorSetLayoutCreateInfo& info);
+
+        size_t getLayoutCount() const { return layoutCache.size(); }
 
         struct DescriptorLayoutInfo {
-            //good idea to turn this into an inlined array
+            vk::DescriptorSetLayoutCreateFlags flags;
             std::vector<vk::DescriptorSetLayoutBinding> bindings;
             bool operator==(const DescriptorLayoutInfo& other) const;
             size_t hash() const;
@@ -153,30 +197,7 @@ namespace Engine {
             std::size_t operator()(const DescriptorLayoutInfo& k) const { return k.hash(); }
         };
 
-        std::unordered_map<DescriptorLayoutInfo, vk::DescriptorSetLayout, DescriptorLayoutHash> layoutCache;
         Device& device;
+        std::unordered_map<DescriptorLayoutInfo, vk::DescriptorSetLayout, DescriptorLayoutHash> layoutCache;
     };
-
-    class DescriptorBuilder {
-    public:
-        DescriptorBuilder(DescriptorLayoutCache& cache, DescriptorAllocator& allocator);
-        ~DescriptorBuilder();
-        DescriptorBuilder(const DescriptorBuilder&) = delete;
-        DescriptorBuilder(DescriptorBuilder&&) = delete;
-        DescriptorBuilder& operator=(const DescriptorBuilder&) = delete;
-        DescriptorBuilder& operator=(DescriptorBuilder&&) = delete;
-
-        DescriptorBuilder& bindBuffer(uint32_t binding, vk::DescriptorBufferInfo& bufferInfo, vk::DescriptorType type, vk::ShaderStageFlags stageFlags);
-        DescriptorBuilder& bindImage(uint32_t binding, vk::DescriptorImageInfo& imageInfo, vk::DescriptorType type, vk::ShaderStageFlags stageFlags);
-
-        bool build(vk::DescriptorSet& set, vk::DescriptorSetLayout& layout);
-        bool build(vk::DescriptorSet& set);
-    private:
-
-        std::vector<vk::WriteDescriptorSet> writes;
-        std::vector<vk::DescriptorSetLayoutBinding> bindings;
-
-        DescriptorLayoutCache& cache;
-        DescriptorAllocator& allocator;
-    };*/
 };
@@ -27,17 +27,38 @@ void DestroyDebugUtilsMessengerEXT(VkInstance instance, VkDebugUtilsMessengerEXT
     }
 }
 
-Device::Device(const Window& window) {
+Device::Device(const Window& window) : deletionQueue{*this} {
     createInstance();
     setupDebugMessenger();
     createSurface(window);
     pickPhysicalDevice();
     createLogicalDevice();
     createCommandPool();
+    createPipelineCache();
+    createTimelineSemaphore();
+}
+
+Device::Device() : deletionQueue{*this}, headless{true}, deviceExtensions{} {
+    createInstance();
+    setupDebugMessenger();
+    pickPhysicalDevice();
+    createLogicalDevice();
+    createCommandPool();
+    createPipelineCache();
+    createTimelineSemaphore();
 }
 
 Device::~Device() {
-    instance.destroySurfaceKHR(surface);
+    logicalDevice.waitIdle();
+    deletionQueue.flushAll();
+
+    savePipelineCache();
+    logicalDevice.destroyPipelineCache(pipelineCache);
+    logicalDevice.destroySemaphore(timelineSemaphore);
+
+    if (!headless) {
+        instance.destroySurfaceKHR(surface);
+    }
 
     if (enableValidationLayers) {
         DestroyDebugUtilsMessengerEXT(instance, callback, nullptr);
@@ -69,7 +90,7 @@ void Device::createInstance() {
             version,
             "No Engine",
             version,
-            VK_API_VERSION_1_0
+            VK_API_VERSION_1_3
     };
 
     hasGflwRequiredInstanceExtensions();
@@ -100,11 +121,15 @@ void Device::createInstance() {
 }
 
 std::vector<const char*> Device::getRequiredExtensions() const {
-    uint32_t glfwExtensionCount = 0;
-    const char** glfwExtensions;
-    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-    std::vector<const char *> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    std::vector<const char *> extensions;
+
+    // surface extensions are only needed to present, glfw may not even be initialized without a window
+    if (!headless) {
+        uint32_t glfwExtensionCount = 0;
+        const char** glfwExtensions;
+        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+        extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    }
 
     if (enableValidationLayers) {
         extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -211,13 +236,29 @@ bool Device::isDeviceSuitable(const vk::PhysicalDevice& device) const {
 
     bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-    bool swapChainAdequate = false;
-    if (extensionsSupported) {
+    bool swapChainAdequate = headless;
+    if (extensionsSupported && !headless) {
         SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
         swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
     }
 
-    return indices.isComplete() && extensionsSupported && swapChainAdequate;
+    return indices.isComplete() && extensionsSupported && swapChainAdequate && checkFeatureSupport(device);
+}
+
+bool Device::checkFeatureSupport(const vk::PhysicalDevice& device) const {
+    if (device.getProperties().apiVersion < VK_API_VERSION_1_2)
+        return false;
+
+    // bindless materials index a partially bound texture array from the fragment shader
+    auto features = device.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>();
+    const auto& features10 = features.get<vk::PhysicalDeviceFeatures2>().features;
+    const auto& features12 = features.get<vk::PhysicalDeviceVulkan12Features>();
+
+    return features10.shaderSampledImageArrayDynamicIndexing &&
+           features12.timelineSemaphore &&
+           features12.runtimeDescriptorArray &&
+           features12.descriptorBindingPartiallyBound &&
+           features12.descriptorBindingSampledImageUpdateAfterBind;
 }
 
 bool Device::checkDeviceExtensionSupport(const vk::PhysicalDevice& device) const {
@@ -239,10 +280,15 @@ QueueFamilyIndices Device::findQueueFamilies(const vk::PhysicalDevice& device) c
             indices.graphicsFamily = i;
         }
 
-        if (queueFamily.queueCount > 0 && device.getSurfaceSupportKHR(i, surface)) {
+        if (queueFamily.queueCount > 0 && !headless && device.getSurfaceSupportKHR(i, surface)) {
             indices.presentFamily = i;
         }
 
+        // nothing is presented, the present queue is just the graphics queue
+        if (headless) {
+            indices.presentFamily = indices.graphicsFamily;
+        }
+
         if (indices.isComplete()) {
             break;
         }
@@ -253,6 +299,78 @@ QueueFamilyIndices Device::findQueueFamilies(const vk::PhysicalDevice& device) c
     return indices;
 }
 
+void Device::createPipelineCache() {
+    std::vector<char> data;
+
+    std::ifstream file{getPipelineCachePath(), std::ios::ate | std::ios::binary};
+    if (file.is_open()) {
+        data.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+
+    // data from another driver or GPU is useless, start from an empty cache
+    if (!file || !isPipelineCacheCompatible(data)) {
+        data.clear();
+    }
+
+    vk::PipelineCacheCreateInfo createInfo{};
+    createInfo.initialDataSize = data.size();
+    createInfo.pInitialData = data.data();
+
+    try {
+        pipelineCache = logicalDevice.createPipelineCache(createInfo);
+    } catch (vk::SystemError& err) {
+        throw std::runtime_error("failed to create pipeline cache!");
+    }
+}
+
+void Device::savePipelineCache() const {
+    // a failed save only costs a slower next launch
+    try {
+        auto data = logicalDevice.getPipelineCacheData(pipelineCache);
+
+        std::filesystem::create_directories(PIPELINE_CACHE_DIRECTORY);
+
+        // write a temporary file first, so a crash never leaves a truncated cache behind
+        std::string path = getPipelineCachePath();
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream file{temporary, std::ios::binary | std::ios::trunc};
+            file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+            if (!file) {
+                throw std::runtime_error("failed to write file: " + temporary);
+            }
+        }
+        std::filesystem::rename(temporary, path);
+    } catch (const std::exception& e) {
+        std::cerr << "failed to save pipeline cache: " << e.what() << std::endl;
+    }
+}
+
+std::string Device::getPipelineCachePath() const {
+    auto properties = physicalDevice.getProperties();
+
+    std::stringstream path;
+    path << PIPELINE_CACHE_DIRECTORY << "/pipeline_" << std::hex << properties.vendorID << "_" << properties.deviceID << "_" << properties.driverVersion << ".bin";
+    return path.str();
+}
+
+bool Device::isPipelineCacheCompatible(const std::vector<char>& data) const {
+    VkPipelineCacheHeaderVersionOne header;
+    if (data.size() < sizeof(header))
+        return false;
+
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    auto properties = physicalDevice.getProperties();
+    return header.headerSize >= sizeof(header) &&
+           header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+           header.vendorID == properties.vendorID &&
+           header.deviceID == properties.deviceID &&
+           std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID.data(), VK_UUID_SIZE) == 0;
+}
+
 void Device::createLogicalDevice() {
     QueueFamilyIndices indices = findPhysicalQueueFamilies();
     std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentFamily.value() };
@@ -270,13 +388,35 @@ void Device::createLogicalDevice() {
         );
     }
 
-    auto deviceFeatures = vk::PhysicalDeviceFeatures();
+    auto supportedFeatures = physicalDevice.getFeatures();
+    enabledFeatures = vk::PhysicalDeviceFeatures();
+    enabledFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+    enabledFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+    enabledFeatures.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+
+    enabledVulkan12Features = vk::PhysicalDeviceVulkan12Features();
+    enabledVulkan12Features.timelineSemaphore = VK_TRUE;
+    enabledVulkan12Features.runtimeDescriptorArray = VK_TRUE;
+    enabledVulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+    enabledVulkan12Features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+
+    // optional, the renderer falls back to render pass objects without it
+    enabledVulkan13Features = vk::PhysicalDeviceVulkan13Features();
+    if (physicalDevice.getProperties().apiVersion >= VK_API_VERSION_1_3) {
+        auto supported = physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan13Features>();
+        enabledVulkan13Features.dynamicRendering = supported.get<vk::PhysicalDeviceVulkan13Features>().dynamicRendering;
+        enabledVulkan12Features.pNext = &enabledVulkan13Features;
+    }
+
+    // core features go through features2 once the chain is used
+    vk::PhysicalDeviceFeatures2 features2{enabledFeatures, &enabledVulkan12Features};
+
     auto createInfo = vk::DeviceCreateInfo(
         vk::DeviceCreateFlags(),
         static_cast<uint32_t>(queueCreateInfos.size()),
         queueCreateInfos.data()
     );
-    createInfo.pEnabledFeatures = &deviceFeatures;
+    createInfo.pNext = &features2;
     createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
     createInfo.ppEnabledExtensionNames = deviceExtensions.data();
 
@@ -339,15 +479,24 @@ vk::Format Device::findSupportedFormat(const std::vector<vk::Format>& candidates
 }
 
 uint32_t Device::findMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties) const {
+    uint32_t index;
+    if (!tryFindMemoryType(typeFilter, properties, index)) {
+        throw std::runtime_error("failed to find suitable memory type!");
+    }
+    return index;
+}
+
+bool Device::tryFindMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties, uint32_t& index) const {
     vk::PhysicalDeviceMemoryProperties memProperties = physicalDevice.getMemoryProperties();
 
     for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
         if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-            return i;
+            index = i;
+            return true;
         }
     }
 
-    throw std::runtime_error("failed to find suitable memory type!");
+    return false;
 }
 
 void Device::createBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, vk::Buffer& buffer, vk::DeviceMemory& bufferMemory) const {
@@ -387,6 +536,7 @@ void Device::copyBuffer(const vk::Buffer& srcBuffer, vk::Buffer& dstBuffer, vk::
     commandBuffer.copyBuffer(srcBuffer, dstBuffer, copyRegion);
 
     endSingleTimeCommands(commandBuffer);
+    transferCount++;
 }
 
 void Device::copyBufferToImage(const vk::Buffer& buffer, const vk::Image& image, uint32_t width, uint32_t height, uint32_t layerCount) const {
@@ -408,6 +558,37 @@ void Device::copyBufferToImage(const vk::Buffer& buffer, const vk::Image& image,
     commandBuffer.copyBufferToImage(buffer, image, vk::ImageLayout::eTransferDstOptimal, 1, &region);
 
     endSingleTimeCommands(commandBuffer);
+    transferCount++;
+}
+
+void Device::createTimelineSemaphore() {
+    vk::SemaphoreTypeCreateInfo typeInfo{};
+    typeInfo.semaphoreType = vk::SemaphoreType::eTimeline;
+    typeInfo.initialValue = 0;
+
+    vk::SemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.pNext = &typeInfo;
+
+    try {
+        timelineSemaphore = logicalDevice.createSemaphore(semaphoreInfo);
+    } catch (vk::SystemError& err) {
+        throw std::runtime_error("failed to create timeline semaphore!");
+    }
+}
+
+uint64_t Device::getCompletedTimelineValue() const {
+    return logicalDevice.getSemaphoreCounterValue(timelineSemaphore);
+}
+
+void Device::waitTimeline(uint64_t value) const {
+    vk::SemaphoreWaitInfo waitInfo{};
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &timelineSemaphore;
+    waitInfo.pValues = &value;
+
+    if (logicalDevice.waitSemaphores(waitInfo, std::numeric_limits<uint64_t>::max()) != vk::Result::eSuccess) {
+        throw std::runtime_error("failed to wait for timeline semaphore!");
+    }
 }
 
 vk::CommandBuffer Device::beginSingleTimeCommands() const {
@@ -429,12 +610,22 @@ vk::CommandBuffer Device::beginSingleTimeCommands() const {
 void Device::endSingleTimeCommands(const vk::CommandBuffer& commandBuffer) const {
     commandBuffer.end();
 
+    // wait for this submission only, frames in flight keep running
+    uint64_t value = nextTimelineValue();
+
+    vk::TimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues = &value;
+
     vk::SubmitInfo submitInfo{};
+    submitInfo.pNext = &timelineInfo;
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &commandBuffer;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &timelineSemaphore;
 
     graphicsQueue.submit(submitInfo, nullptr);
-    graphicsQueue.waitIdle();
+    waitTimeline(value);
 
     logicalDevice.freeCommandBuffers(commandPool, commandBuffer);
 }
@@ -526,7 +717,10 @@ void Device::createImage(uint32_t width, uint32_t height, vk::Format format, vk:
 
     vk::MemoryAllocateInfo allocInfo{};
     allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+    // lazily allocated memory only exists on tiled GPUs, everywhere else plain device memory does the job
+    if (!tryFindMemoryType(memRequirements.memoryTypeBits, properties, allocInfo.memoryTypeIndex)) {
+        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties & ~vk::MemoryPropertyFlags(vk::MemoryPropertyFlagBits::eLazilyAllocated));
+    }
 
     try {
         imageMemory = logicalDevice.allocateMemory(allocInfo);
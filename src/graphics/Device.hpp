@@ -1,5 +1,7 @@
 #pragma once
 
+#include "DeletionQueue.hpp"
+
 namespace Engine {
     struct SwapChainSupportDetails {
         vk::SurfaceCapabilitiesKHR capabilities;
@@ -26,6 +28,8 @@ namespace Engine {
 #endif
     public:
         Device(const Window& window);
+        //! Headless device without a surface or presentation support, for offscreen rendering.
+        Device();
         ~Device();
         Device(const Device&) = delete;
         Device(Device&&) = delete;
@@ -38,6 +42,14 @@ namespace Engine {
         const vk::Queue& getGraphicsQueue() const { return graphicsQueue; };
         const vk::Queue& getPresentQueue() const { return presentQueue; };
         const vk::CommandPool& getCommandPool() const { return commandPool; };
+        const vk::PhysicalDeviceFeatures& getEnabledFeatures() const { return enabledFeatures; };
+        const vk::PhysicalDeviceVulkan12Features& getEnabledVulkan12Features() const { return enabledVulkan12Features; };
+        //! Only filled on Vulkan 1.3 devices, all features read false otherwise.
+        const vk::PhysicalDeviceVulkan13Features& getEnabledVulkan13Features() const { return enabledVulkan13Features; };
+        DeletionQueue& getDeletionQueue() { return deletionQueue; };
+        const vk::Semaphore& getTimelineSemaphore() const { return timelineSemaphore; };
+        const vk::PipelineCache& getPipelineCache() const { return pipelineCache; };
+        bool isHeadless() const { return headless; };
 
         SwapChainSupportDetails getSwapChainSupport() const { return querySwapChainSupport(physicalDevice); };
         QueueFamilyIndices findPhysicalQueueFamilies() const { return findQueueFamilies(physicalDevice); };
@@ -46,9 +58,21 @@ namespace Engine {
         void createBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, vk::Buffer& buffer, vk::DeviceMemory& bufferMemory) const;
         void copyBuffer(const vk::Buffer& srcBuffer, vk::Buffer& dstBuffer, vk::DeviceSize size) const;
         void copyBufferToImage(const vk::Buffer& buffer, const vk::Image& image, uint32_t width, uint32_t height, uint32_t layerCount) const;
+        //! eLazilyAllocated in \a properties is a preference, it is dropped when no memory type has it.
         void createImage(uint32_t width, uint32_t height, vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage, vk::MemoryPropertyFlags properties, vk::Image& image, vk::DeviceMemory& imageMemory) const;
         void transitionImageLayout(const vk::Image& image, vk::Format format, vk::ImageLayout oldLayout, vk::ImageLayout newLayout) const;
         vk::ImageView createImageView(const vk::Image& image, vk::Format format, vk::ImageAspectFlags aspectFlags) const;
+        uint32_t findMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties) const;
+        //! Number of staging copies into buffers and images so far, from any thread.
+        uint64_t getTransferCount() const { return transferCount; };
+        //! Writes the pipeline cache to disk, so the next launch can skip shader compilation.
+        void savePipelineCache() const;
+
+        //! Reserves the timeline value the next submission signals, values only ever increase.
+        uint64_t nextTimelineValue() const { return ++timelineValue; };
+        uint64_t getCompletedTimelineValue() const;
+        //! Blocks until the timeline semaphore has reached \a value.
+        void waitTimeline(uint64_t value) const;
 
     private:
         void createInstance();
@@ -57,18 +81,23 @@ namespace Engine {
         void pickPhysicalDevice();
         void createLogicalDevice();
         void createCommandPool();
+        void createPipelineCache();
+        void createTimelineSemaphore();
 
         std::vector<const char*> getRequiredExtensions() const;
         bool checkValidationLayerSupport() const;
         void hasGflwRequiredInstanceExtensions() const;
         bool isDeviceSuitable(const vk::PhysicalDevice& device) const;
         bool checkDeviceExtensionSupport(const vk::PhysicalDevice& device) const;
+        bool checkFeatureSupport(const vk::PhysicalDevice& device) const;
         QueueFamilyIndices findQueueFamilies(const vk::PhysicalDevice& device) const;
         SwapChainSupportDetails querySwapChainSupport(const vk::PhysicalDevice& device) const;
 
         vk::CommandBuffer beginSingleTimeCommands() const;
         void endSingleTimeCommands(const vk::CommandBuffer& commandBuffer) const;
-        uint32_t findMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties) const;
+        bool tryFindMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties, uint32_t& index) const;
+        std::string getPipelineCachePath() const;
+        bool isPipelineCacheCompatible(const std::vector<char>& data) const;
 
         static bool hasStencilComponent(vk::Format format) ;
 
@@ -79,10 +108,22 @@ namespace Engine {
         vk::Queue presentQueue;
         vk::SurfaceKHR surface;
         vk::CommandPool commandPool;
+        vk::PipelineCache pipelineCache;
+        //! Signaled by every queue submission, frame pacing and deferred deletion wait on its values.
+        vk::Semaphore timelineSemaphore;
+        mutable std::atomic<uint64_t> timelineValue{0};
+        mutable std::atomic<uint64_t> transferCount{0};
+        vk::PhysicalDeviceFeatures enabledFeatures;
+        vk::PhysicalDeviceVulkan12Features enabledVulkan12Features;
+        vk::PhysicalDeviceVulkan13Features enabledVulkan13Features;
+        DeletionQueue deletionQueue;
 
         VkDebugUtilsMessengerEXT callback{nullptr};
+        bool headless{false};
 
         const std::vector<const char*> validationLayers = {"VK_LAYER_KHRONOS_validation"};
         const std::vector<const char*> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+
+        static constexpr const char* PIPELINE_CACHE_DIRECTORY = "cache";
     };
 }
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include "GpuProfiler.hpp"
+#include "Device.hpp"
+
+#include <iomanip>
+
+using Engine::GpuProfiler;
+
+GpuProfiler::GpuProfiler(Device& device, uint32_t frameCount, bool enabled) : device{device}, enabled{enabled} {
+    auto graphicsFamily = device.findPhysicalQueueFamilies().graphicsFamily.value();
+    uint32_t validBits = device.getPhysical().getQueueFamilyProperties()[graphicsFamily].timestampValidBits;
+
+    if (validBits == 0) {
+        std::cerr << "gpu profiler: timestamps are not supported on the graphics queue" << std::endl;
+        this->enabled = false;
+    }
+
+    if (!this->enabled)
+        return;
+
+    timestampPeriod = device.getPhysical().getProperties().limits.timestampPeriod;
+    timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+    vk::QueryPoolCreateInfo poolInfo{};
+    poolInfo.queryType = vk::QueryType::eTimestamp;
+    poolInfo.queryCount = MAX_SCOPES * 2;
+
+    frames.resize(frameCount);
+    for (auto& frame : frames) {
+        try {
+            frame.queryPool = device.getLogical().createQueryPool(poolInfo);
+        } catch (vk::SystemError& err) {
+            throw std::runtime_error("failed to create timestamp query pool!");
+        }
+    }
+}
+
+GpuProfiler::~GpuProfiler() {
+    for (const auto& frame : frames) {
+        device.getLogical().destroyQueryPool(frame.queryPool);
+    }
+}
+
+void GpuProfiler::beginFrame(const vk::CommandBuffer& commandBuffer, uint32_t frameIndex) {
+    if (!enabled)
+        return;
+
+    currentFrame = frameIndex;
+    auto& frame = frames[currentFrame];
+
+    collect(frame);
+    commandBuffer.resetQueryPool(frame.queryPool, 0, MAX_SCOPES * 2);
+}
+
+uint32_t GpuProfiler::beginScope(const vk::CommandBuffer& commandBuffer, const std::string& name) {
+    if (!enabled)
+        return INVALID_SCOPE;
+
+    auto& frame = frames[currentFrame];
+    if (frame.scopes.size() == MAX_SCOPES)
+        return INVALID_SCOPE;
+
+    auto scope = static_cast<uint32_t>(frame.scopes.size());
+    frame.scopes.push_back(name);
+    commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, frame.queryPool, scope * 2);
+    return scope;
+}
+
+void GpuProfiler::endScope(const vk::CommandBuffer& commandBuffer, uint32_t scope) {
+    if (scope == INVALID_SCOPE)
+        return;
+
+    commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, frames[currentFrame].queryPool, scope * 2 + 1);
+}
+
+void GpuProfiler::collect(Frame& frame) {
+    if (frame.scopes.empty())
+        return;
+
+    auto queryCount = static_cast<uint32_t>(frame.scopes.size() * 2);
+    std::vector<uint64_t> timestamps(queryCount);
+
+    // no wait flag, a frame that is somehow not done yet is dropped instead of stalling
+    auto result = device.getLogical().getQueryPoolResults(
+        frame.queryPool,
+        0,
+        queryCount,
+        timestamps.size() * sizeof(uint64_t),
+        timestamps.data(),
+        sizeof(uint64_t),
+        vk::QueryResultFlagBits::e64);
+
+    if (result == vk::Result::eSuccess) {
+        for (size_t i = 0; i < frame.scopes.size(); i++) {
+            auto ticks = (timestamps[i * 2 + 1] - timestamps[i * 2]) & timestampMask;
+
+            auto& samples = history[frame.scopes[i]];
+            samples.push_back(static_cast<double>(ticks) * timestampPeriod / 1e6);
+            if (samples.size() > HISTORY_SIZE) {
+                samples.pop_front();
+            }
+        }
+    }
+
+    frame.scopes.clear();
+}
+
+GpuProfiler::Stats GpuProfiler::getStats(const std::string& name) const {
+    Stats stats{};
+
+    auto it = history.find(name);
+    if (it == history.end() || it->second.empty())
+        return stats;
+
+    std::vector<double> samples{it->second.begin(), it->second.end()};
+    std::sort(samples.begin(), samples.end());
+
+    auto percentile = [&samples](double p) {
+        return samples[static_cast<size_t>(p * static_cast<double>(samples.size() - 1) + 0.5)];
+    };
+
+    stats.average = std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size());
+    stats.median = percentile(0.5);
+    stats.p95 = percentile(0.95);
+    stats.max = samples.back();
+    stats.samples = samples.size();
+    return stats;
+}
+
+void GpuProfiler::report(std::ostream& out) const {
+    if (history.empty())
+        return;
+
+    out << "gpu time (ms)        avg      p50      p95      max" << std::endl;
+    for (const auto& [name, samples] : history) {
+        auto stats = getStats(name);
+        out << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(3)
+            << std::setw(9) << stats.average
+            << std::setw(9) << stats.median
+            << std::setw(9) << stats.p95
+            << std::setw(9) << stats.max << std::endl;
+    }
+}
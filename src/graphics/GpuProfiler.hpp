@@ -0,0 +1,64 @@
+#pragma once
+
+namespace Engine {
+    class Device;
+
+    /// @brief GPU time of named scopes from timestamp queries
+    /// Every frame in flight has its own query pool. Its results are read when the frame comes around again,
+    /// the timeline value of the frame has been reached by then, so the read never waits for the GPU.
+    /// Times are kept for the last HISTORY_SIZE frames a scope was recorded in.
+    /// @link https://registry.khronos.org/vulkan/specs/1.3-extensions/html/vkspec.html#queries-timestamps
+    class GpuProfiler {
+    public:
+        static constexpr uint32_t MAX_SCOPES = 64;
+        static constexpr size_t HISTORY_SIZE = 240;
+        static constexpr uint32_t INVALID_SCOPE = std::numeric_limits<uint32_t>::max();
+
+        //! Milliseconds over the recorded history of a scope.
+        struct Stats {
+            double average{0};
+            double median{0};
+            double p95{0};
+            double max{0};
+            size_t samples{0};
+        };
+
+        //! Without timestamp support on the graphics queue or when not \a enabled, scopes record nothing.
+        GpuProfiler(Device& device, uint32_t frameCount, bool enabled);
+        ~GpuProfiler();
+        GpuProfiler(const GpuProfiler&) = delete;
+        GpuProfiler(GpuProfiler&&) = delete;
+        GpuProfiler& operator=(const GpuProfiler&) = delete;
+        GpuProfiler& operator=(GpuProfiler&&) = delete;
+
+        //! Collects the results of the last use of \a frameIndex and resets its queries, outside of a render pass.
+        void beginFrame(const vk::CommandBuffer& commandBuffer, uint32_t frameIndex);
+        //! INVALID_SCOPE when disabled or out of queries, ending it does nothing then.
+        uint32_t beginScope(const vk::CommandBuffer& commandBuffer, const std::string& name);
+        void endScope(const vk::CommandBuffer& commandBuffer, uint32_t scope);
+
+        bool isEnabled() const { return enabled; };
+        Stats getStats(const std::string& name) const;
+        //! Writes the stats of every scope, one line each.
+        void report(std::ostream& out) const;
+
+    private:
+        struct Frame {
+            vk::QueryPool queryPool;
+            //! Scope names in query order, two timestamps each.
+            std::vector<std::string> scopes;
+        };
+
+        void collect(Frame& frame);
+
+        Device& device;
+        bool enabled;
+        //! Nanoseconds per timestamp tick.
+        double timestampPeriod{0};
+        uint64_t timestampMask{0};
+
+        std::vector<Frame> frames;
+        uint32_t currentFrame{0};
+        std::map<std::string, std::deque<double>> history;
+    };
+}
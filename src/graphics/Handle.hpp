@@ -0,0 +1,35 @@
+#pragma once
+
+namespace Engine {
+    class Mesh;
+    class Texture;
+    struct Material;
+
+    /// @brief Typed reference to a resource stored in a \c ResourcePool
+    /// The generation changes every time a slot is reused, so a handle to a released resource never resolves to its successor
+    template<typename T>
+    struct Handle {
+        uint32_t index{INVALID_INDEX};
+        uint32_t generation{0};
+
+        bool isValid() const { return index != INVALID_INDEX; };
+
+        bool operator==(const Handle& other) const { return index == other.index && generation == other.generation; };
+        bool operator!=(const Handle& other) const { return !(*this == other); };
+
+        static constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+    };
+
+    using MeshHandle = Handle<Mesh>;
+    using TextureHandle = Handle<Texture>;
+    using MaterialHandle = Handle<Material>;
+}
+
+namespace std {
+    template<typename T>
+    struct hash<Engine::Handle<T>> {
+        size_t operator()(const Engine::Handle<T>& handle) const {
+            return hash<uint64_t>{}((uint64_t{handle.generation} << 32) | handle.index);
+        }
+    };
+}
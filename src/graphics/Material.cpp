@@ -0,0 +1,3 @@
+#include "Material.hpp"
+
+using Engine::Material;
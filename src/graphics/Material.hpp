@@ -0,0 +1,10 @@
+#pragma once
+
+#include "Handle.hpp"
+
+namespace Engine {
+    struct Material {
+        glm::vec4 baseColor{1};
+        TextureHandle albedo;
+    };
+}
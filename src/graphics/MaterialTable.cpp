@@ -0,0 +1,172 @@
+#include "MaterialTable.hpp"
+#include "Device.hpp"
+#include "Texture.hpp"
+#include "Material.hpp"
+#include "AllocatedBuffer.hpp"
+#include "Descriptors.hpp"
+
+using Engine::MaterialTable;
+
+MaterialTable::MaterialTable(Device& device, uint32_t frameCount) : device{device} {
+    // combined image samplers count against both the sampler and the sampled image limits
+    auto properties = device.getPhysical().getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceVulkan12Properties>();
+    const auto& limits = properties.get<vk::PhysicalDeviceVulkan12Properties>();
+    textureCapacity = std::min({MAX_TEXTURES,
+                                limits.maxPerStageDescriptorUpdateAfterBindSamplers,
+                                limits.maxPerStageDescriptorUpdateAfterBindSampledImages});
+
+    uint32_t white = 0xFFFFFFFF;
+    defaultTexture = std::make_unique<Texture>(device, &white, 1, 1, vk::Format::eR8G8B8A8Unorm);
+
+    vk::DescriptorImageInfo defaultInfo{};
+    defaultInfo.sampler = defaultTexture->getSampler();
+    defaultInfo.imageView = defaultTexture->getView();
+    defaultInfo.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+    textures.resize(textureCapacity, defaultInfo);
+
+    materials.resize(MAX_MATERIALS);
+
+    pool = DescriptorPool::Builder(device)
+            .setMaxSets(frameCount)
+            .addPoolSize(vk::DescriptorType::eCombinedImageSampler, textureCapacity * frameCount)
+            .addPoolSize(vk::DescriptorType::eStorageBuffer, frameCount)
+            .setPoolFlags(vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind)
+            .build();
+
+    layout = DescriptorLayout::Builder(device)
+            .addBinding(0, vk::DescriptorType::eCombinedImageSampler, vk::ShaderStageFlagBits::eFragment, textureCapacity)
+            .addBinding(1, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eFragment)
+            .setBindingFlags(0, vk::DescriptorBindingFlagBits::ePartiallyBound | vk::DescriptorBindingFlagBits::eUpdateAfterBind)
+            .build();
+
+    frames.resize(frameCount);
+    for (auto& frame : frames) {
+        frame.materialBuffer = std::make_unique<AllocatedBuffer>(
+            device,
+            sizeof(GpuMaterial),
+            MAX_MATERIALS,
+            vk::BufferUsageFlagBits::eStorageBuffer,
+            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+        frame.materialBuffer->map();
+
+        auto bufferInfo = frame.materialBuffer->descriptorInfo();
+        if (!DescriptorWriter(*layout, *pool).writeBuffer(1, bufferInfo).build(frame.descriptorSet)) {
+            throw std::runtime_error("failed to allocate material descriptor set!");
+        }
+
+        // every slot starts out as the default texture
+        vk::WriteDescriptorSet write{};
+        write.dstSet = frame.descriptorSet;
+        write.dstBinding = 0;
+        write.dstArrayElement = 0;
+        write.descriptorCount = textureCapacity;
+        write.descriptorType = vk::DescriptorType::eCombinedImageSampler;
+        write.pImageInfo = textures.data();
+        device.getLogical().updateDescriptorSets(1, &write, 0, nullptr);
+    }
+}
+
+MaterialTable::~MaterialTable() {
+}
+
+void MaterialTable::setTexture(TextureHandle handle, const Texture& texture) {
+    uint32_t index = getIndex(handle);
+    if (index == DEFAULT_INDEX) {
+        std::cerr << "bindless texture table is full, " << texture.getPath() << " falls back to the default texture" << std::endl;
+        return;
+    }
+
+    textures[index].sampler = texture.getSampler();
+    textures[index].imageView = texture.getView();
+    markTexture(index);
+}
+
+void MaterialTable::removeTexture(TextureHandle handle) {
+    uint32_t index = getIndex(handle);
+    if (index == DEFAULT_INDEX)
+        return;
+
+    textures[index] = textures[DEFAULT_INDEX];
+    markTexture(index);
+}
+
+void MaterialTable::setMaterial(MaterialHandle handle, const Material& material) {
+    uint32_t index = getIndex(handle);
+    if (index == DEFAULT_INDEX) {
+        std::cerr << "material table is full, material falls back to the default" << std::endl;
+        return;
+    }
+
+    auto& gpuMaterial = materials[index];
+    gpuMaterial.baseColor = material.baseColor;
+    gpuMaterial.albedo = getIndex(material.albedo);
+
+    materialCount = std::max(materialCount, index + 1);
+    markMaterials();
+}
+
+void MaterialTable::removeMaterial(MaterialHandle handle) {
+    uint32_t index = getIndex(handle);
+    if (index == DEFAULT_INDEX)
+        return;
+
+    materials[index] = GpuMaterial{};
+    markMaterials();
+}
+
+void MaterialTable::update(uint32_t frameIndex) {
+    auto& frame = frames[frameIndex];
+
+    if (!frame.dirtyTextures.empty()) {
+        std::vector<vk::WriteDescriptorSet> writes;
+        writes.reserve(frame.dirtyTextures.size());
+
+        for (uint32_t index : frame.dirtyTextures) {
+            vk::WriteDescriptorSet write{};
+            write.dstSet = frame.descriptorSet;
+            write.dstBinding = 0;
+            write.dstArrayElement = index;
+            write.descriptorCount = 1;
+            write.descriptorType = vk::DescriptorType::eCombinedImageSampler;
+            write.pImageInfo = &textures[index];
+            writes.push_back(write);
+        }
+
+        device.getLogical().updateDescriptorSets(static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+        frame.dirtyTextures.clear();
+    }
+
+    if (frame.materialsDirty) {
+        std::memcpy(frame.materialBuffer->getMappedMemory(), materials.data(), materialCount * sizeof(GpuMaterial));
+        frame.materialsDirty = false;
+    }
+}
+
+uint32_t MaterialTable::getIndex(TextureHandle handle) const {
+    // slot 0 is taken by the default texture
+    if (!handle.isValid() || handle.index + 1 >= textureCapacity)
+        return DEFAULT_INDEX;
+    return handle.index + 1;
+}
+
+uint32_t MaterialTable::getIndex(MaterialHandle handle) const {
+    if (!handle.isValid() || handle.index + 1 >= MAX_MATERIALS)
+        return DEFAULT_INDEX;
+    return handle.index + 1;
+}
+
+const vk::DescriptorSetLayout& MaterialTable::getDescriptorSetLayout() const {
+    return layout->getDescriptorSetLayout();
+}
+
+void MaterialTable::markTexture(uint32_t index) {
+    for (auto& frame : frames) {
+        frame.dirtyTextures.push_back(index);
+    }
+}
+
+void MaterialTable::markMaterials() {
+    for (auto& frame : frames) {
+        frame.materialsDirty = true;
+    }
+}
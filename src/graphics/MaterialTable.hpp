@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Handle.hpp"
+
+namespace Engine {
+    class Device;
+    class Texture;
+    class AllocatedBuffer;
+    class DescriptorPool;
+    class DescriptorLayout;
+
+    /// @brief GPU side of materials, addressed by index instead of per draw descriptor sets
+    /// Set layout: binding 0 is a partially bound, update after bind array of every loaded texture,
+    /// binding 1 a storage buffer of material parameters. Draws only push the index of their material.
+    /// Each frame in flight has its own set and material buffer, changes are applied to a frame
+    /// once its previous submission has completed, so nothing the GPU may still read is overwritten.
+    /// @link https://www.khronos.org/blog/vk-ext-descriptor-indexing
+    class MaterialTable {
+    public:
+        //! Index 0 holds a white texture and a white untextured material.
+        static constexpr uint32_t DEFAULT_INDEX = 0;
+        static constexpr uint32_t MAX_TEXTURES = 4096;
+        static constexpr uint32_t MAX_MATERIALS = 16384;
+
+        //! Matches the std430 layout of Material in mesh.frag.
+        struct GpuMaterial {
+            glm::vec4 baseColor{1};
+            uint32_t albedo{DEFAULT_INDEX};
+            uint32_t padding[3]{};
+        };
+
+        MaterialTable(Device& device, uint32_t frameCount);
+        ~MaterialTable();
+        MaterialTable(const MaterialTable&) = delete;
+        MaterialTable(MaterialTable&&) = delete;
+        MaterialTable& operator=(const MaterialTable&) = delete;
+        MaterialTable& operator=(MaterialTable&&) = delete;
+
+        void setTexture(TextureHandle handle, const Texture& texture);
+        void removeTexture(TextureHandle handle);
+        void setMaterial(MaterialHandle handle, const Material& material);
+        void removeMaterial(MaterialHandle handle);
+
+        //! Applies every change made since \a frameIndex was last updated.
+        void update(uint32_t frameIndex);
+
+        //! Shader index of \a handle, the default white texture or material if it does not fit the table.
+        uint32_t getIndex(TextureHandle handle) const;
+        uint32_t getIndex(MaterialHandle handle) const;
+
+        const vk::DescriptorSetLayout& getDescriptorSetLayout() const;
+        const vk::DescriptorSet& getDescriptorSet(uint32_t frameIndex) const { return frames[frameIndex].descriptorSet; };
+
+    private:
+        struct Frame {
+            std::unique_ptr<AllocatedBuffer> materialBuffer;
+            vk::DescriptorSet descriptorSet;
+            std::vector<uint32_t> dirtyTextures;
+            bool materialsDirty{true};
+        };
+
+        void markTexture(uint32_t index);
+        void markMaterials();
+
+        Device& device;
+        uint32_t textureCapacity;
+        std::unique_ptr<Texture> defaultTexture;
+        std::unique_ptr<DescriptorPool> pool;
+        std::unique_ptr<DescriptorLayout> layout;
+        //! Descriptor of every texture slot, empty slots point at the default texture.
+        std::vector<vk::DescriptorImageInfo> textures;
+        std::vector<GpuMaterial> materials;
+        //! One past the highest material index in use, only this range is uploaded.
+        uint32_t materialCount{1};
+        std::vector<Frame> frames;
+    };
+}
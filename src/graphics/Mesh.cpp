@@ -1,25 +1,79 @@
 #include "Mesh.hpp"
 #include "AllocatedBuffer.hpp"
 #include "Device.hpp"
+#include "MeshSimplifier.hpp"
+#include "MeshCodec.hpp"
+#include "../geometry/Frustum.hpp"
 
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader.h>
 
 using Engine::Mesh;
+using Engine::Meshlet;
+using Engine::MeshCodec;
 
-Mesh::Mesh(Device& device, const Builder& builder) : device{device} {
-    createVertexBuffers(builder.vertices);
-    createIndexBuffers(builder.indices);
+namespace {
+    //! Layout of the compressed mesh file, followed by lods, meshlets, vertex and index streams.
+    struct MeshFileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t vertexCount;
+        uint32_t vertexStride;
+        uint32_t indexCount;
+        uint32_t lodCount;
+        uint32_t meshletCount;
+        uint32_t vertexDataSize;
+        uint32_t indexDataSize;
+        glm::vec3 boxMin;
+        glm::vec3 boxMax;
+        glm::vec3 center;
+        float radius;
+    };
+
+    constexpr uint32_t MESH_FILE_MAGIC = 0x48534D45; // "EMSH"
+    constexpr uint32_t MESH_FILE_VERSION = 2;
+
+    static_assert(std::is_trivially_copyable_v<Meshlet> && std::is_trivially_copyable_v<Mesh::Lod>, "Mesh file sections are copied as raw bytes");
+}
+
+Mesh::Mesh(Device& device, const Builder& builder) : device{device}, meshlets{builder.meshlets}, lods{builder.lods}, boundingBox{builder.boundingBox}, boundingSphere{builder.boundingSphere} {
+    const auto& vertices = builder.vertices;
+    createVertexBuffers(static_cast<uint32_t>(vertices.size()), [&](void* mapped) {
+        std::memcpy(mapped, vertices.data(), sizeof(Vertex) * vertices.size());
+    });
+
+    const auto& indices = builder.indices;
+    createIndexBuffers(static_cast<uint32_t>(indices.size()), [&](void* mapped) {
+        std::memcpy(mapped, indices.data(), sizeof(uint32_t) * indices.size());
+    });
+
+    if (lods.empty()) {
+        lods.push_back({0, indexCount, 0});
+    }
+}
+
+Mesh::Mesh(Device& device, const Compressed& compressed) : device{device}, meshlets{compressed.meshlets}, lods{compressed.lods}, boundingBox{compressed.boundingBox}, boundingSphere{compressed.boundingSphere} {
+    createVertexBuffers(compressed.vertexCount, [&](void* mapped) {
+        MeshCodec::decodeVertices(mapped, compressed.vertexCount, sizeof(Vertex), compressed.vertices.data(), compressed.vertices.size());
+    });
+
+    createIndexBuffers(compressed.indexCount, [&](void* mapped) {
+        MeshCodec::decodeIndices(static_cast<uint32_t*>(mapped), compressed.indexCount, compressed.indices.data(), compressed.indices.size());
+    });
+
+    if (lods.empty()) {
+        lods.push_back({0, indexCount, 0});
+    }
 }
 
 Mesh::~Mesh() {
 }
 
-void Mesh::createVertexBuffers(const std::vector<Vertex>& vertices) {
-    vertexCount = static_cast<uint32_t>(vertices.size());
+void Mesh::createVertexBuffers(uint32_t count, const std::function<void(void*)>& fill) {
+    vertexCount = count;
     assert(vertexCount >= 3 && "Vertex count must be at least 3");
-    vk::DeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
-    uint32_t vertexSize = sizeof(vertices[0]);
+    vk::DeviceSize bufferSize = sizeof(Vertex) * vertexCount;
+    uint32_t vertexSize = sizeof(Vertex);
 
     AllocatedBuffer stagingBuffer{
         device,
@@ -30,7 +84,7 @@ void Mesh::createVertexBuffers(const std::vector<Vertex>& vertices) {
     };
 
     stagingBuffer.map();
-    stagingBuffer.writeToBuffer((void *)vertices.data());
+    fill(stagingBuffer.getMappedMemory());
 
     vertexBuffer = std::make_unique<AllocatedBuffer>(
         device,
@@ -42,16 +96,16 @@ void Mesh::createVertexBuffers(const std::vector<Vertex>& vertices) {
     device.copyBuffer(stagingBuffer.get(), vertexBuffer->get(), bufferSize);
 }
 
-void Mesh::createIndexBuffers(const std::vector<uint32_t>& indices) {
-    indexCount = static_cast<uint32_t>(indices.size());
+void Mesh::createIndexBuffers(uint32_t count, const std::function<void(void*)>& fill) {
+    indexCount = count;
     hasIndexBuffer = indexCount > 0;
 
     if (!hasIndexBuffer) {
         return;
     }
 
-    vk::DeviceSize bufferSize = sizeof(indices[0]) * indexCount;
-    uint32_t indexSize = sizeof(indices[0]);
+    vk::DeviceSize bufferSize = sizeof(uint32_t) * indexCount;
+    uint32_t indexSize = sizeof(uint32_t);
 
     AllocatedBuffer stagingBuffer {
         device,
@@ -62,7 +116,7 @@ void Mesh::createIndexBuffers(const std::vector<uint32_t>& indices) {
     };
 
     stagingBuffer.map();
-    stagingBuffer.writeToBuffer((void *)indices.data());
+    fill(stagingBuffer.getMappedMemory());
 
     indexBuffer = std::make_unique<AllocatedBuffer>(
         device,
@@ -82,6 +136,77 @@ void Mesh::draw(const vk::CommandBuffer& commandBuffer) const {
     }
 }
 
+void Mesh::drawLod(const vk::CommandBuffer& commandBuffer, uint32_t lod) const {
+    if (!hasIndexBuffer) {
+        draw(commandBuffer);
+        return;
+    }
+
+    const auto& range = lods[lod];
+    commandBuffer.drawIndexed(range.indexCount, 1, range.indexOffset, 0, 0);
+}
+
+uint32_t Mesh::selectLod(float screenSize) const {
+    uint32_t lod = 0;
+    float threshold = LOD_SCREEN_SIZE;
+
+    while (lod + 1 < lods.size() && screenSize < threshold) {
+        threshold *= 0.5f;
+        lod++;
+    }
+
+    return lod;
+}
+
+void Mesh::drawIndirect(const vk::CommandBuffer& commandBuffer, const vk::Buffer& buffer, vk::DeviceSize offset, uint32_t drawCount) const {
+    assert(hasIndexBuffer && "Indirect draws require an index buffer");
+
+    constexpr uint32_t stride = sizeof(vk::DrawIndexedIndirectCommand);
+
+    if (device.getEnabledFeatures().multiDrawIndirect) {
+        commandBuffer.drawIndexedIndirect(buffer, offset, drawCount, stride);
+    } else {
+        for (uint32_t i = 0; i < drawCount; i++) {
+            commandBuffer.drawIndexedIndirect(buffer, offset + i * stride, 1, stride);
+        }
+    }
+}
+
+uint32_t Mesh::cullMeshlets(const Frustum& frustum, const glm::vec3& cameraPosition, vk::DrawIndexedIndirectCommand* commands, uint32_t capacity, uint32_t& indexCount) const {
+    assert(capacity >= meshlets.size() && "Indirect command buffer is too small");
+
+    uint32_t count = 0;
+    indexCount = 0;
+    // commands usually live in write-combined memory, so accumulate locally and never read them back
+    vk::DrawIndexedIndirectCommand pending{0, 1, 0, 0, 0};
+
+    for (const auto& meshlet : meshlets) {
+        if (!meshlet.isVisible(frustum, cameraPosition))
+            continue;
+
+        indexCount += meshlet.indexCount;
+
+        // merge adjacent index ranges into a single draw
+        if (pending.indexCount > 0 && pending.firstIndex + pending.indexCount == meshlet.indexOffset) {
+            pending.indexCount += meshlet.indexCount;
+            continue;
+        }
+
+        if (pending.indexCount > 0) {
+            commands[count++] = pending;
+        }
+
+        pending.firstIndex = meshlet.indexOffset;
+        pending.indexCount = meshlet.indexCount;
+    }
+
+    if (pending.indexCount > 0) {
+        commands[count++] = pending;
+    }
+
+    return count;
+}
+
 void Mesh::bind(const vk::CommandBuffer& commandBuffer) const {
     vk::Buffer buffers[] = {vertexBuffer->get()};
     vk::DeviceSize offsets[] = {0};
@@ -130,6 +255,8 @@ void Mesh::Builder::loadModel(const std::string &filepath) {
 
     vertices.clear();
     indices.clear();
+    meshlets.clear();
+    lods.clear();
 
     std::unordered_map<Vertex, uint32_t> uniqueVertices{};
     for (const auto &shape : shapes) {
@@ -172,4 +299,152 @@ void Mesh::Builder::loadModel(const std::string &filepath) {
             indices.push_back(uniqueVertices[vertex]);
         }
     }
-}
\ No newline at end of file
+
+    calculateBounds();
+}
+
+void Mesh::Builder::calculateBounds() {
+    if (vertices.empty()) {
+        boundingBox = {};
+        boundingSphere = {};
+        return;
+    }
+
+    boundingBox = AABB::calculateBoundingBox(&vertices[0].position, vertices.size(), sizeof(Vertex));
+    boundingSphere = Sphere::calculateBoundingSphere(&vertices[0].position, vertices.size(), sizeof(Vertex));
+}
+
+void Mesh::Builder::buildMeshlets(size_t maxVertices, size_t maxTriangles) {
+    if (indices.empty()) {
+        // meshlets reference triangles through the index buffer
+        indices.resize(vertices.size());
+        std::iota(indices.begin(), indices.end(), 0);
+    }
+
+    std::vector<glm::vec3> positions;
+    positions.reserve(vertices.size());
+    for (const auto& vertex : vertices) {
+        positions.push_back(vertex.position);
+    }
+
+    // only the full detail level is clustered, simplified levels follow it in the index buffer
+    meshlets = Meshlet::build(positions, indices.data(), getBaseIndexCount(), maxVertices, maxTriangles);
+}
+
+void Mesh::Builder::generateLods(size_t count, float ratio, float maxError) {
+    assert(ratio > 0 && ratio < 1 && "Ratio must be in (0, 1) range");
+
+    if (indices.empty()) {
+        indices.resize(vertices.size());
+        std::iota(indices.begin(), indices.end(), 0);
+    }
+
+    // drop previously generated levels
+    indices.resize(getBaseIndexCount());
+    lods.clear();
+    lods.push_back({0, static_cast<uint32_t>(indices.size()), 0});
+
+    std::vector<glm::vec3> positions;
+    positions.reserve(vertices.size());
+    for (const auto& vertex : vertices) {
+        positions.push_back(vertex.position);
+    }
+
+    std::vector<uint32_t> source{indices};
+    for (size_t i = 0; i < count; ++i) {
+        size_t targetIndexCount = static_cast<size_t>(static_cast<float>(source.size() / 3) * ratio) * 3;
+
+        float error;
+        auto lod = MeshSimplifier::simplify(positions, source, targetIndexCount, maxError, &error);
+
+        // a level that saves less than 10% of the triangles is not worth a switch
+        if (lod.empty() || lod.size() * 10 > source.size() * 9)
+            break;
+
+        lods.push_back({static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(lod.size()), error});
+        indices.insert(indices.end(), lod.begin(), lod.end());
+        source = std::move(lod);
+    }
+}
+
+size_t Mesh::Builder::getBaseIndexCount() const {
+    return lods.empty() ? indices.size() : lods.front().indexCount;
+}
+
+Mesh::Compressed Mesh::Builder::compress() const {
+    Compressed compressed{};
+    compressed.vertexCount = static_cast<uint32_t>(vertices.size());
+    compressed.indexCount = static_cast<uint32_t>(indices.size());
+    compressed.vertices = MeshCodec::encodeVertices(vertices.data(), vertices.size(), sizeof(Vertex));
+    compressed.indices = MeshCodec::encodeIndices(indices.data(), indices.size());
+    compressed.meshlets = meshlets;
+    compressed.lods = lods;
+    compressed.boundingBox = boundingBox;
+    compressed.boundingSphere = boundingSphere;
+
+    return compressed;
+}
+
+void Mesh::Compressed::save(const std::string& filepath) const {
+    std::ofstream file{filepath, std::ios::binary};
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open file: " + filepath);
+    }
+
+    MeshFileHeader header{};
+    header.magic = MESH_FILE_MAGIC;
+    header.version = MESH_FILE_VERSION;
+    header.vertexCount = vertexCount;
+    header.vertexStride = sizeof(Vertex);
+    header.indexCount = indexCount;
+    header.lodCount = static_cast<uint32_t>(lods.size());
+    header.meshletCount = static_cast<uint32_t>(meshlets.size());
+    header.vertexDataSize = static_cast<uint32_t>(vertices.size());
+    header.indexDataSize = static_cast<uint32_t>(indices.size());
+    header.boxMin = boundingBox.getMin();
+    header.boxMax = boundingBox.getMax();
+    header.center = boundingSphere.getCenter();
+    header.radius = boundingSphere.getRadius();
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(lods.data()), static_cast<std::streamsize>(sizeof(Lod) * lods.size()));
+    file.write(reinterpret_cast<const char*>(meshlets.data()), static_cast<std::streamsize>(sizeof(Meshlet) * meshlets.size()));
+    file.write(reinterpret_cast<const char*>(vertices.data()), static_cast<std::streamsize>(vertices.size()));
+    file.write(reinterpret_cast<const char*>(indices.data()), static_cast<std::streamsize>(indices.size()));
+
+    if (!file) {
+        throw std::runtime_error("failed to write file: " + filepath);
+    }
+}
+
+void Mesh::Compressed::load(const std::string& filepath) {
+    std::ifstream file{filepath, std::ios::binary};
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open file: " + filepath);
+    }
+
+    MeshFileHeader header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || header.magic != MESH_FILE_MAGIC || header.version != MESH_FILE_VERSION || header.vertexStride != sizeof(Vertex)) {
+        throw std::runtime_error("failed to load mesh, unsupported file: " + filepath);
+    }
+
+    vertexCount = header.vertexCount;
+    indexCount = header.indexCount;
+    boundingBox = {header.boxMin, header.boxMax};
+    boundingSphere = {header.center, header.radius};
+
+    lods.resize(header.lodCount);
+    meshlets.resize(header.meshletCount);
+    vertices.resize(header.vertexDataSize);
+    indices.resize(header.indexDataSize);
+
+    file.read(reinterpret_cast<char*>(lods.data()), static_cast<std::streamsize>(sizeof(Lod) * lods.size()));
+    file.read(reinterpret_cast<char*>(meshlets.data()), static_cast<std::streamsize>(sizeof(Meshlet) * meshlets.size()));
+    file.read(reinterpret_cast<char*>(vertices.data()), static_cast<std::streamsize>(vertices.size()));
+    file.read(reinterpret_cast<char*>(indices.data()), static_cast<std::streamsize>(indices.size()));
+
+    if (!file) {
+        throw std::runtime_error("failed to load mesh, file is truncated: " + filepath);
+    }
+}
@@ -1,8 +1,13 @@
 #pragma once
 
+#include "Meshlet.hpp"
+#include "../geometry/Sphere.hpp"
+#include "../geometry/AABB.hpp"
+
 namespace Engine {
     class Device;
     class AllocatedBuffer;
+    class Frustum;
 
     class Mesh {
     public:
@@ -20,14 +25,52 @@ namespace Engine {
             }
         };
 
+        //! Range of the index buffer with the triangles of one level of detail.
+        struct Lod {
+            uint32_t indexOffset{0};
+            uint32_t indexCount{0};
+            //! Simplification error, relative to the mesh extents.
+            float error{0};
+        };
+
+        //! Mesh with vertex and index streams encoded by \c MeshCodec, as stored on disk.
+        struct Compressed {
+            uint32_t vertexCount{0};
+            uint32_t indexCount{0};
+            std::vector<uint8_t> vertices;
+            std::vector<uint8_t> indices;
+            std::vector<Meshlet> meshlets;
+            std::vector<Lod> lods;
+            AABB boundingBox;
+            Sphere boundingSphere;
+
+            void save(const std::string& filepath) const;
+            void load(const std::string& filepath);
+        };
+
         struct Builder {
             std::vector<Vertex> vertices;
             std::vector<uint32_t> indices;
+            std::vector<Meshlet> meshlets;
+            std::vector<Lod> lods;
+            AABB boundingBox;
+            Sphere boundingSphere;
 
             void loadModel(const std::string &filepath);
+            //! Recomputes the local bounds from the vertex positions, must be called after the vertices are edited by hand.
+            void calculateBounds();
+            void buildMeshlets(size_t maxVertices = Meshlet::MAX_VERTICES, size_t maxTriangles = Meshlet::MAX_TRIANGLES);
+            //! Appends up to \a count simplified levels to the index buffer, each with \a ratio of the triangles of the previous one.
+            void generateLods(size_t count = 3, float ratio = 0.5f, float maxError = 0.05f);
+            Compressed compress() const;
+
+        private:
+            size_t getBaseIndexCount() const;
         };
 
         Mesh(Device& device, const Builder& builder);
+        //! Decodes the streams of \a compressed straight into the staging buffers.
+        Mesh(Device& device, const Compressed& compressed);
         ~Mesh();
         Mesh(const Mesh&) = delete;
         Mesh(Mesh&&) = delete;
@@ -36,10 +79,30 @@ namespace Engine {
 
         void bind(const vk::CommandBuffer& commandBuffer) const;
         void draw(const vk::CommandBuffer& commandBuffer) const;
+        void drawLod(const vk::CommandBuffer& commandBuffer, uint32_t lod) const;
+        void drawIndirect(const vk::CommandBuffer& commandBuffer, const vk::Buffer& buffer, vk::DeviceSize offset, uint32_t drawCount) const;
+
+        uint32_t getLodCount() const { return static_cast<uint32_t>(lods.size()); };
+        const Lod& getLod(uint32_t lod) const { return lods[lod]; };
+        //! Triangles of a full detail draw.
+        uint32_t getTriangleCount() const { return (hasIndexBuffer ? indexCount : vertexCount) / 3; };
+        //! Picks the level of detail for a mesh whose bounding sphere covers \a screenSize of the viewport height.
+        uint32_t selectLod(float screenSize) const;
+        //! Size of the vertex and index buffers in device memory.
+        vk::DeviceSize getMemorySize() const { return sizeof(Vertex) * vertexCount + sizeof(uint32_t) * indexCount; };
+        const AABB& getBoundingBox() const { return boundingBox; };
+        const Sphere& getBoundingSphere() const { return boundingSphere; };
+
+        bool hasMeshlets() const { return !meshlets.empty(); };
+        const std::vector<Meshlet>& getMeshlets() const { return meshlets; };
+        //! Writes indirect draws for the meshlets visible from \a cameraPosition inside \a frustum (both in the mesh local space) and returns the number of commands.
+        //! Each command draws one instance, \a indexCount receives the indices of all of them.
+        uint32_t cullMeshlets(const Frustum& frustum, const glm::vec3& cameraPosition, vk::DrawIndexedIndirectCommand* commands, uint32_t capacity, uint32_t& indexCount) const;
 
     private:
-        void createVertexBuffers(const std::vector<Vertex>& vertices);
-        void createIndexBuffers(const std::vector<uint32_t>& indices);
+        //! Creates a device local buffer for \a count vertices, \a fill writes them into the mapped staging memory.
+        void createVertexBuffers(uint32_t count, const std::function<void(void*)>& fill);
+        void createIndexBuffers(uint32_t count, const std::function<void(void*)>& fill);
 
         Device& device;
         std::unique_ptr<AllocatedBuffer> vertexBuffer;
@@ -47,6 +110,14 @@ namespace Engine {
         bool hasIndexBuffer = false;
         std::unique_ptr<AllocatedBuffer> indexBuffer;
         uint32_t indexCount;
+        std::vector<Meshlet> meshlets;
+        std::vector<Lod> lods;
+        AABB boundingBox;
+        Sphere boundingSphere;
+
+    public:
+        //! Screen size below which the first simplified level is used, every next level halves it.
+        static constexpr float LOD_SCREEN_SIZE = 0.5f;
     };
 }
 
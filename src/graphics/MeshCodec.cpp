@@ -0,0 +1,438 @@
+#include "MeshCodec.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MESH_CODEC_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(MESH_CODEC_SSE2) && (defined(__GNUC__) || defined(_MSC_VER))
+#define MESH_CODEC_SSSE3
+#include <tmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define MESH_CODEC_SSSE3_TARGET
+#else
+#define MESH_CODEC_SSSE3_TARGET __attribute__((target("ssse3")))
+#endif
+#endif
+
+using Engine::MeshCodec;
+
+namespace {
+    //! Encoded size of a group of 16 bytes for every 2-bit mode.
+    constexpr size_t GROUP_SIZES[4] = { 0, 4, 8, 16 };
+
+    uint8_t zigzag8(uint8_t value) {
+        return static_cast<uint8_t>((value << 1) ^ static_cast<uint8_t>(static_cast<int8_t>(value) >> 7));
+    }
+
+#ifndef MESH_CODEC_SSE2
+    uint8_t unzigzag8(uint8_t value) {
+        return static_cast<uint8_t>((value >> 1) ^ static_cast<uint8_t>(-(value & 1)));
+    }
+#endif
+
+    void corrupted(const char* stream) {
+        throw std::runtime_error(std::string{"failed to decode "} + stream + " stream, data is corrupted!");
+    }
+
+#ifdef MESH_CODEC_SSSE3
+    bool hasSsse3() {
+        static const bool supported = [] {
+#ifdef _MSC_VER
+            int info[4];
+            __cpuid(info, 1);
+            return (info[2] & (1 << 9)) != 0;
+#else
+            return __builtin_cpu_supports("ssse3") != 0;
+#endif
+        }();
+        return supported;
+    }
+
+    //! Shuffle masks and data lengths for every control byte of the index stream.
+    struct IndexTables {
+        alignas(16) uint8_t shuffle[256][16];
+        uint8_t length[256];
+
+        IndexTables() {
+            for (uint32_t key = 0; key < 256; ++key) {
+                uint8_t offset = 0;
+                for (uint32_t j = 0; j < 4; ++j) {
+                    uint32_t bytes = ((key >> (j * 2)) & 3) + 1;
+                    for (uint32_t b = 0; b < 4; ++b) {
+                        shuffle[key][j * 4 + b] = b < bytes ? static_cast<uint8_t>(offset + b) : 0x80;
+                    }
+                    offset += static_cast<uint8_t>(bytes);
+                }
+                length[key] = offset;
+            }
+        }
+    };
+
+    //! Decodes groups of 4 indices while at least 16 bytes of data remain, returns the number of decoded indices.
+    MESH_CODEC_SSSE3_TARGET
+    size_t decodeIndicesSsse3(uint32_t* destination, size_t count, const uint8_t* control, const uint8_t*& data, const uint8_t* end, uint32_t& previous) {
+        static const IndexTables tables;
+
+        const __m128i one = _mm_set1_epi32(1);
+        __m128i last = _mm_set1_epi32(static_cast<int>(previous));
+
+        size_t i = 0;
+        for (; i + 4 <= count && end - data >= 16; i += 4) {
+            uint8_t key = control[i / 4];
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+            __m128i value = _mm_shuffle_epi8(bytes, _mm_load_si128(reinterpret_cast<const __m128i*>(tables.shuffle[key])));
+            data += tables.length[key];
+
+            // zigzag, then prefix sum of the deltas on top of the last decoded index
+            __m128i delta = _mm_xor_si128(_mm_srli_epi32(value, 1), _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(value, one)));
+            delta = _mm_add_epi32(delta, _mm_slli_si128(delta, 4));
+            delta = _mm_add_epi32(delta, _mm_slli_si128(delta, 8));
+            last = _mm_add_epi32(delta, _mm_shuffle_epi32(last, 0xFF));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), last);
+        }
+
+        previous = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_shuffle_epi32(last, 0xFF)));
+        return i;
+    }
+#endif
+
+#ifdef MESH_CODEC_SSE2
+    //! Expands a group of 16 values packed with 0, 2, 4 or 8 bits each into bytes.
+    __m128i unpackGroup(const uint8_t* data, uint32_t mode) {
+        switch (mode) {
+            case 0:
+                return _mm_setzero_si128();
+            case 1: {
+                int32_t packed;
+                std::memcpy(&packed, data, sizeof(packed));
+                // every packed byte is repeated 4 times, then each lane picks its own 2 bits
+                __m128i value = _mm_cvtsi32_si128(packed);
+                value = _mm_unpacklo_epi8(value, value);
+                value = _mm_unpacklo_epi16(value, value);
+                const __m128i mask0 = _mm_set1_epi32(0x00000003);
+                const __m128i mask1 = _mm_set1_epi32(0x00000300);
+                const __m128i mask2 = _mm_set1_epi32(0x00030000);
+                const __m128i mask3 = _mm_set1_epi32(0x03000000);
+                __m128i result = _mm_and_si128(value, mask0);
+                result = _mm_or_si128(result, _mm_and_si128(_mm_srli_epi16(value, 2), mask1));
+                result = _mm_or_si128(result, _mm_and_si128(_mm_srli_epi16(value, 4), mask2));
+                result = _mm_or_si128(result, _mm_and_si128(_mm_srli_epi16(value, 6), mask3));
+                return result;
+            }
+            case 2: {
+                __m128i value = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data));
+                value = _mm_unpacklo_epi8(value, value);
+                const __m128i maskLow = _mm_set1_epi16(0x000F);
+                const __m128i maskHigh = _mm_set1_epi16(0x0F00);
+                return _mm_or_si128(_mm_and_si128(value, maskLow), _mm_and_si128(_mm_srli_epi16(value, 4), maskHigh));
+            }
+            default:
+                return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+        }
+    }
+#endif
+}
+
+std::vector<uint8_t> MeshCodec::encodeIndices(const uint32_t* indices, size_t count) {
+    size_t controlSize = (count + 3) / 4;
+
+    std::vector<uint8_t> result(controlSize, 0);
+    result.reserve(controlSize + count * 2);
+
+    uint32_t previous = 0;
+    for (size_t i = 0; i < count; ++i) {
+        auto delta = static_cast<int32_t>(indices[i] - previous);
+        previous = indices[i];
+
+        uint32_t value = (static_cast<uint32_t>(delta) << 1) ^ static_cast<uint32_t>(delta >> 31);
+        uint32_t length = value < (1u << 8) ? 1 : value < (1u << 16) ? 2 : value < (1u << 24) ? 3 : 4;
+
+        result[i / 4] |= static_cast<uint8_t>((length - 1) << ((i % 4) * 2));
+        for (uint32_t b = 0; b < length; ++b) {
+            result.push_back(static_cast<uint8_t>(value >> (b * 8)));
+        }
+    }
+
+    return result;
+}
+
+void MeshCodec::decodeIndices(uint32_t* destination, size_t count, const uint8_t* data, size_t size) {
+    size_t controlSize = (count + 3) / 4;
+    if (size < controlSize)
+        corrupted("index");
+
+    const uint8_t* control = data;
+    const uint8_t* end = data + size;
+    data += controlSize;
+
+    uint32_t previous = 0;
+    size_t i = 0;
+
+#ifdef MESH_CODEC_SSSE3
+    if (hasSsse3()) {
+        i = decodeIndicesSsse3(destination, count, control, data, end, previous);
+    }
+#endif
+
+    for (; i < count; ++i) {
+        uint32_t length = ((control[i / 4] >> ((i % 4) * 2)) & 3) + 1;
+        if (static_cast<size_t>(end - data) < length)
+            corrupted("index");
+
+        uint32_t value = 0;
+        for (uint32_t b = 0; b < length; ++b) {
+            value |= uint32_t{data[b]} << (b * 8);
+        }
+        data += length;
+
+        previous += (value >> 1) ^ (0u - (value & 1));
+        destination[i] = previous;
+    }
+
+    if (data != end)
+        corrupted("index");
+}
+
+std::vector<uint8_t> MeshCodec::encodeVertices(const void* vertices, size_t count, size_t stride) {
+    assert(stride > 0 && stride <= MAX_VERTEX_STRIDE && stride % 4 == 0 && "Vertex stride must be a multiple of 4");
+
+    const auto* bytes = static_cast<const uint8_t*>(vertices);
+    size_t channelCount = stride / 4;
+
+    std::vector<uint8_t> result;
+    result.reserve(count * stride / 2);
+
+    std::vector<uint8_t> last(stride, 0);
+    std::vector<uint8_t> delta, exclusive;
+
+    for (size_t begin = 0; begin < count; begin += VERTEX_BLOCK_SIZE) {
+        size_t blockCount = std::min(VERTEX_BLOCK_SIZE, count - begin);
+        const uint8_t* block = bytes + begin * stride;
+
+        size_t filterOffset = result.size();
+        result.resize(result.size() + channelCount);
+
+        // pick the cheaper filter for every attribute channel
+        for (size_t channel = 0; channel < channelCount; ++channel) {
+            delta.clear();
+            exclusive.clear();
+            for (size_t k = channel * 4; k < channel * 4 + 4; ++k) {
+                encodePlane(delta, block + k, blockCount, stride, last[k], FILTER_DELTA);
+                encodePlane(exclusive, block + k, blockCount, stride, last[k], FILTER_XOR);
+            }
+
+            const auto& best = exclusive.size() < delta.size() ? exclusive : delta;
+            result[filterOffset + channel] = &best == &exclusive ? FILTER_XOR : FILTER_DELTA;
+            result.insert(result.end(), best.begin(), best.end());
+        }
+
+        std::memcpy(last.data(), block + (blockCount - 1) * stride, stride);
+    }
+
+    return result;
+}
+
+void MeshCodec::decodeVertices(void* destination, size_t count, size_t stride, const uint8_t* data, size_t size) {
+    assert(stride > 0 && stride <= MAX_VERTEX_STRIDE && stride % 4 == 0 && "Vertex stride must be a multiple of 4");
+
+    auto* output = static_cast<uint8_t*>(destination);
+    const uint8_t* end = data + size;
+    size_t channelCount = stride / 4;
+
+    // planes and the transposed block stay in cache, destination may be write-combined memory
+    std::vector<uint8_t> planes(VERTEX_BLOCK_SIZE * stride);
+    std::vector<uint8_t> block(VERTEX_BLOCK_SIZE * stride);
+    std::vector<uint8_t> last(stride, 0);
+
+    for (size_t begin = 0; begin < count; begin += VERTEX_BLOCK_SIZE) {
+        size_t blockCount = std::min(VERTEX_BLOCK_SIZE, count - begin);
+
+        if (static_cast<size_t>(end - data) < channelCount)
+            corrupted("vertex");
+
+        const uint8_t* filters = data;
+        data += channelCount;
+
+        for (size_t k = 0; k < stride; ++k) {
+            uint8_t filter = filters[k / 4];
+            if (filter != FILTER_DELTA && filter != FILTER_XOR)
+                corrupted("vertex");
+
+            uint8_t* plane = &planes[k * VERTEX_BLOCK_SIZE];
+            data = decodePlane(plane, blockCount, data, end, last[k], static_cast<Filter>(filter));
+            last[k] = plane[blockCount - 1];
+        }
+
+        transposeBlock(block.data(), planes.data(), blockCount, stride);
+        std::memcpy(output + begin * stride, block.data(), blockCount * stride);
+    }
+
+    if (data != end)
+        corrupted("vertex");
+}
+
+void MeshCodec::encodePlane(std::vector<uint8_t>& out, const uint8_t* source, size_t count, size_t stride, uint8_t previous, Filter filter) {
+    size_t groupCount = (count + 15) / 16;
+
+    // padding repeats the previous value, so it encodes as zero for both filters
+    uint8_t values[VERTEX_BLOCK_SIZE] = {};
+    for (size_t i = 0; i < count; ++i) {
+        uint8_t value = source[i * stride];
+        values[i] = filter == FILTER_XOR ? value ^ previous : zigzag8(static_cast<uint8_t>(value - previous));
+        previous = value;
+    }
+
+    size_t headerOffset = out.size();
+    out.resize(out.size() + (groupCount + 3) / 4, 0);
+
+    for (size_t g = 0; g < groupCount; ++g) {
+        const uint8_t* group = values + g * 16;
+        uint8_t maxValue = *std::max_element(group, group + 16);
+        uint32_t mode = maxValue == 0 ? 0 : maxValue < 4 ? 1 : maxValue < 16 ? 2 : 3;
+
+        out[headerOffset + g / 4] |= static_cast<uint8_t>(mode << ((g % 4) * 2));
+
+        switch (mode) {
+            case 1:
+                for (size_t j = 0; j < 4; ++j) {
+                    out.push_back(static_cast<uint8_t>(group[j * 4] | (group[j * 4 + 1] << 2) | (group[j * 4 + 2] << 4) | (group[j * 4 + 3] << 6)));
+                }
+                break;
+            case 2:
+                for (size_t j = 0; j < 8; ++j) {
+                    out.push_back(static_cast<uint8_t>(group[j * 2] | (group[j * 2 + 1] << 4)));
+                }
+                break;
+            case 3:
+                out.insert(out.end(), group, group + 16);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+const uint8_t* MeshCodec::decodePlane(uint8_t* plane, size_t count, const uint8_t* data, const uint8_t* end, uint8_t previous, Filter filter) {
+    size_t groupCount = (count + 15) / 16;
+    size_t headerSize = (groupCount + 3) / 4;
+    if (static_cast<size_t>(end - data) < headerSize)
+        corrupted("vertex");
+
+    const uint8_t* headers = data;
+    data += headerSize;
+
+    // validate the whole plane once, so the group loop needs no checks
+    size_t dataSize = 0;
+    for (size_t g = 0; g < groupCount; ++g) {
+        dataSize += GROUP_SIZES[(headers[g / 4] >> ((g % 4) * 2)) & 3];
+    }
+    if (static_cast<size_t>(end - data) < dataSize)
+        corrupted("vertex");
+
+#ifdef MESH_CODEC_SSE2
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i low = _mm_set1_epi8(0x7F);
+    __m128i last = _mm_set1_epi8(static_cast<char>(previous));
+
+    for (size_t g = 0; g < groupCount; ++g) {
+        uint32_t mode = (headers[g / 4] >> ((g % 4) * 2)) & 3;
+        __m128i value = unpackGroup(data, mode);
+        data += GROUP_SIZES[mode];
+
+        // prefix sum (or xor) of 16 bytes in log steps, continued from the last byte of the previous group
+        if (filter == FILTER_XOR) {
+            value = _mm_xor_si128(value, _mm_slli_si128(value, 1));
+            value = _mm_xor_si128(value, _mm_slli_si128(value, 2));
+            value = _mm_xor_si128(value, _mm_slli_si128(value, 4));
+            value = _mm_xor_si128(value, _mm_slli_si128(value, 8));
+            value = _mm_xor_si128(value, last);
+        } else {
+            value = _mm_xor_si128(_mm_and_si128(_mm_srli_epi16(value, 1), low), _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(value, one)));
+            value = _mm_add_epi8(value, _mm_slli_si128(value, 1));
+            value = _mm_add_epi8(value, _mm_slli_si128(value, 2));
+            value = _mm_add_epi8(value, _mm_slli_si128(value, 4));
+            value = _mm_add_epi8(value, _mm_slli_si128(value, 8));
+            value = _mm_add_epi8(value, last);
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(plane + g * 16), value);
+        last = _mm_set1_epi8(static_cast<char>(plane[g * 16 + 15]));
+    }
+#else
+    for (size_t g = 0; g < groupCount; ++g) {
+        uint32_t mode = (headers[g / 4] >> ((g % 4) * 2)) & 3;
+
+        uint8_t values[16] = {};
+        switch (mode) {
+            case 1:
+                for (size_t i = 0; i < 16; ++i) {
+                    values[i] = (data[i / 4] >> ((i % 4) * 2)) & 3;
+                }
+                break;
+            case 2:
+                for (size_t i = 0; i < 16; ++i) {
+                    values[i] = (data[i / 2] >> ((i % 2) * 4)) & 15;
+                }
+                break;
+            case 3:
+                std::memcpy(values, data, 16);
+                break;
+            default:
+                break;
+        }
+        data += GROUP_SIZES[mode];
+
+        for (size_t i = 0; i < 16; ++i) {
+            previous = filter == FILTER_XOR ? previous ^ values[i] : static_cast<uint8_t>(previous + unzigzag8(values[i]));
+            plane[g * 16 + i] = previous;
+        }
+    }
+#endif
+
+    return data;
+}
+
+void MeshCodec::transposeBlock(uint8_t* block, const uint8_t* planes, size_t count, size_t stride) {
+#ifdef MESH_CODEC_SSE2
+    // interleave 4 planes into 16 vertices worth of 4-byte channels, writes past count land in the padding
+    for (size_t k = 0; k < stride; k += 4) {
+        const uint8_t* plane = planes + k * VERTEX_BLOCK_SIZE;
+
+        for (size_t i = 0; i < count; i += 16) {
+            __m128i p0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(plane + i));
+            __m128i p1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(plane + VERTEX_BLOCK_SIZE + i));
+            __m128i p2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(plane + VERTEX_BLOCK_SIZE * 2 + i));
+            __m128i p3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(plane + VERTEX_BLOCK_SIZE * 3 + i));
+
+            __m128i a0 = _mm_unpacklo_epi8(p0, p1);
+            __m128i a1 = _mm_unpackhi_epi8(p0, p1);
+            __m128i b0 = _mm_unpacklo_epi8(p2, p3);
+            __m128i b1 = _mm_unpackhi_epi8(p2, p3);
+
+            __m128i rows[4] = {
+                _mm_unpacklo_epi16(a0, b0),
+                _mm_unpackhi_epi16(a0, b0),
+                _mm_unpacklo_epi16(a1, b1),
+                _mm_unpackhi_epi16(a1, b1),
+            };
+
+            for (size_t r = 0; r < 4; ++r) {
+                for (size_t j = 0; j < 4; ++j) {
+                    int32_t word = _mm_cvtsi128_si32(rows[r]);
+                    std::memcpy(block + (i + r * 4 + j) * stride + k, &word, sizeof(word));
+                    rows[r] = _mm_srli_si128(rows[r], 4);
+                }
+            }
+        }
+    }
+#else
+    for (size_t i = 0; i < count; ++i) {
+        for (size_t k = 0; k < stride; ++k) {
+            block[i * stride + k] = planes[k * VERTEX_BLOCK_SIZE + i];
+        }
+    }
+#endif
+}
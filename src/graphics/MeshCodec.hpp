@@ -0,0 +1,35 @@
+#pragma once
+
+namespace Engine {
+    /// @brief Lossless compression of vertex and index streams
+    /// Indices are delta and zigzag encoded, then packed into byte groups with a 2-bit length each (stream vbyte).
+    /// Vertices are split into blocks, transposed into byte planes, filtered per 4-byte attribute channel
+    /// (delta or xor against the previous vertex) and bit packed in groups of 16 bytes.
+    /// Decoders use SSE2/SSSE3 when available and a scalar path otherwise.
+    /// @link https://arxiv.org/abs/1709.08990
+    /// @link https://github.com/zeux/meshoptimizer#vertexindex-buffer-compression
+    class MeshCodec {
+    public:
+        static std::vector<uint8_t> encodeIndices(const uint32_t* indices, size_t count);
+        //! Decodes \a count indices into \a destination. Throws if \a data is malformed.
+        static void decodeIndices(uint32_t* destination, size_t count, const uint8_t* data, size_t size);
+
+        //! Encodes \a count vertices of \a stride bytes each. Stride must be a multiple of 4.
+        static std::vector<uint8_t> encodeVertices(const void* vertices, size_t count, size_t stride);
+        //! Decodes \a count vertices into \a destination, writing it strictly in order. Throws if \a data is malformed.
+        static void decodeVertices(void* destination, size_t count, size_t stride, const uint8_t* data, size_t size);
+
+        static constexpr size_t VERTEX_BLOCK_SIZE = 256;
+        static constexpr size_t MAX_VERTEX_STRIDE = 256;
+
+    private:
+        enum Filter : uint8_t {
+            FILTER_DELTA = 0,
+            FILTER_XOR = 1,
+        };
+
+        static void encodePlane(std::vector<uint8_t>& out, const uint8_t* source, size_t count, size_t stride, uint8_t previous, Filter filter);
+        static const uint8_t* decodePlane(uint8_t* plane, size_t count, const uint8_t* data, const uint8_t* end, uint8_t previous, Filter filter);
+        static void transposeBlock(uint8_t* block, const uint8_t* planes, size_t count, size_t stride);
+    };
+}
@@ -0,0 +1,274 @@
+#include "MeshSimplifier.hpp"
+
+using Engine::MeshSimplifier;
+
+MeshSimplifier::Quadric& MeshSimplifier::Quadric::operator+=(const Quadric& other) {
+    a00 += other.a00;
+    a11 += other.a11;
+    a22 += other.a22;
+    a10 += other.a10;
+    a20 += other.a20;
+    a21 += other.a21;
+    b0 += other.b0;
+    b1 += other.b1;
+    b2 += other.b2;
+    c += other.c;
+    weight += other.weight;
+    return *this;
+}
+
+float MeshSimplifier::Quadric::evaluate(const glm::vec3& p) const {
+    float rx = a00 * p.x + a10 * p.y + a20 * p.z + b0;
+    float ry = a10 * p.x + a11 * p.y + a21 * p.z + b1;
+    float rz = a20 * p.x + a21 * p.y + a22 * p.z + b2;
+    // p^T * A * p + 2 * b^T * p + c
+    float error = rx * p.x + ry * p.y + rz * p.z + b0 * p.x + b1 * p.y + b2 * p.z + c;
+    return std::fabs(error);
+}
+
+MeshSimplifier::Quadric MeshSimplifier::Quadric::fromPlane(const glm::vec3& n, float d, float weight) {
+    Quadric q{};
+    q.a00 = weight * n.x * n.x;
+    q.a11 = weight * n.y * n.y;
+    q.a22 = weight * n.z * n.z;
+    q.a10 = weight * n.y * n.x;
+    q.a20 = weight * n.z * n.x;
+    q.a21 = weight * n.z * n.y;
+    q.b0 = weight * n.x * d;
+    q.b1 = weight * n.y * d;
+    q.b2 = weight * n.z * d;
+    q.c = weight * d * d;
+    q.weight = weight;
+    return q;
+}
+
+std::vector<uint32_t> MeshSimplifier::simplify(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, size_t targetIndexCount, float targetError, float* resultError) {
+    assert(indices.size() % 3 == 0 && "Index count must be a multiple of 3");
+
+    std::vector<uint32_t> result{indices};
+    float maxError = 0;
+
+    if (resultError) {
+        *resultError = 0;
+    }
+
+    if (result.size() <= targetIndexCount || positions.empty()) {
+        return result;
+    }
+
+    size_t vertexCount = positions.size();
+
+    // rescale into a unit cube, so the error does not depend on the mesh size
+    glm::vec3 min{positions[0]}, max{positions[0]};
+    for (const auto& position : positions) {
+        min = glm::min(min, position);
+        max = glm::max(max, position);
+    }
+    glm::vec3 size = max - min;
+    float extent = std::max(size.x, std::max(size.y, size.z));
+    float scale = extent > 0 ? 1 / extent : 1;
+
+    std::vector<glm::vec3> points;
+    points.reserve(vertexCount);
+    for (const auto& position : positions) {
+        points.push_back((position - min) * scale);
+    }
+
+    // vertices which share a position but differ in attributes form seams
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<bool> locked(vertexCount, false);
+    {
+        std::unordered_map<glm::vec3, uint32_t> unique;
+        unique.reserve(vertexCount);
+        for (uint32_t v = 0; v < vertexCount; ++v) {
+            auto [it, inserted] = unique.emplace(positions[v], v);
+            remap[v] = it->second;
+            if (!inserted) {
+                locked[v] = true;
+                locked[it->second] = true;
+            }
+        }
+    }
+
+    // open borders keep the silhouette of the mesh
+    {
+        std::unordered_map<uint64_t, uint32_t> edges;
+        edges.reserve(result.size());
+        auto edgeKey = [](uint32_t a, uint32_t b) {
+            return a < b ? (uint64_t{a} << 32) | b : (uint64_t{b} << 32) | a;
+        };
+
+        for (size_t i = 0; i < result.size(); i += 3) {
+            for (size_t k = 0; k < 3; ++k) {
+                uint32_t a = remap[result[i + k]];
+                uint32_t b = remap[result[i + (k + 1) % 3]];
+                edges[edgeKey(a, b)]++;
+            }
+        }
+
+        for (size_t i = 0; i < result.size(); i += 3) {
+            for (size_t k = 0; k < 3; ++k) {
+                uint32_t a = result[i + k];
+                uint32_t b = result[i + (k + 1) % 3];
+                if (edges[edgeKey(remap[a], remap[b])] == 1) {
+                    locked[a] = true;
+                    locked[b] = true;
+                }
+            }
+        }
+    }
+
+    // quadrics are accumulated on the seam representatives
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i < result.size(); i += 3) {
+        const glm::vec3& p0 = points[result[i + 0]];
+        const glm::vec3& p1 = points[result[i + 1]];
+        const glm::vec3& p2 = points[result[i + 2]];
+
+        glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        float area = glm::length(normal);
+        if (area == 0)
+            continue;
+
+        normal /= area;
+        auto quadric = Quadric::fromPlane(normal, -glm::dot(normal, p0), area);
+
+        quadrics[remap[result[i + 0]]] += quadric;
+        quadrics[remap[result[i + 1]]] += quadric;
+        quadrics[remap[result[i + 2]]] += quadric;
+    }
+
+    float errorLimit = targetError * targetError;
+
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> adjacencyOffsets;
+    std::vector<uint32_t> adjacency;
+    std::vector<uint32_t> collapseTo(vertexCount);
+    std::vector<bool> touched(vertexCount);
+
+    auto hasFlips = [&](uint32_t source, uint32_t target) {
+        for (uint32_t i = adjacencyOffsets[source]; i < adjacencyOffsets[source + 1]; ++i) {
+            const uint32_t* triangle = &result[adjacency[i] * 3];
+            if (triangle[0] == target || triangle[1] == target || triangle[2] == target)
+                continue;
+
+            glm::vec3 p[3], q[3];
+            for (size_t k = 0; k < 3; ++k) {
+                p[k] = points[triangle[k]];
+                q[k] = triangle[k] == source ? points[target] : p[k];
+            }
+
+            glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+            glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+            if (glm::dot(before, after) <= 0)
+                return true;
+        }
+        return false;
+    };
+
+    while (result.size() > targetIndexCount) {
+        size_t triangleCount = result.size() / 3;
+
+        // vertex -> triangles adjacency of the current triangle list
+        adjacencyOffsets.assign(vertexCount + 1, 0);
+        for (uint32_t index : result) {
+            adjacencyOffsets[index + 1]++;
+        }
+        for (size_t v = 0; v < vertexCount; ++v) {
+            adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+        }
+        adjacency.resize(result.size());
+        std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t t = 0; t < triangleCount; ++t) {
+            for (size_t k = 0; k < 3; ++k) {
+                adjacency[fill[result[t * 3 + k]]++] = static_cast<uint32_t>(t);
+            }
+        }
+
+        // every edge is a candidate in both directions, unless its source is locked
+        collapses.clear();
+        for (size_t i = 0; i < result.size(); i += 3) {
+            for (size_t k = 0; k < 3; ++k) {
+                uint32_t a = result[i + k];
+                uint32_t b = result[i + (k + 1) % 3];
+
+                for (auto [source, target] : {std::make_pair(a, b), std::make_pair(b, a)}) {
+                    if (locked[source])
+                        continue;
+
+                    Quadric q = quadrics[remap[source]];
+                    q += quadrics[remap[target]];
+                    float error = q.weight > 0 ? q.evaluate(points[target]) / q.weight : 0;
+                    collapses.push_back({source, target, error});
+                }
+            }
+        }
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) {
+            return a.error < b.error;
+        });
+
+        std::iota(collapseTo.begin(), collapseTo.end(), 0);
+        std::fill(touched.begin(), touched.end(), false);
+
+        size_t removedTriangles = 0;
+        size_t targetRemoved = triangleCount - targetIndexCount / 3;
+        size_t performed = 0;
+
+        for (const auto& collapse : collapses) {
+            if (collapse.error > errorLimit || removedTriangles >= targetRemoved)
+                break;
+
+            uint32_t source = collapse.source;
+            uint32_t target = collapse.target;
+
+            if (touched[source] || touched[target])
+                continue;
+
+            if (hasFlips(source, target))
+                continue;
+
+            collapseTo[source] = target;
+            quadrics[remap[target]] += quadrics[remap[source]];
+            maxError = std::max(maxError, collapse.error);
+            performed++;
+
+            // the whole fan changes shape, keep it stable for the rest of the pass
+            for (uint32_t i = adjacencyOffsets[source]; i < adjacencyOffsets[source + 1]; ++i) {
+                const uint32_t* triangle = &result[adjacency[i] * 3];
+                touched[triangle[0]] = true;
+                touched[triangle[1]] = true;
+                touched[triangle[2]] = true;
+
+                if (triangle[0] == target || triangle[1] == target || triangle[2] == target) {
+                    removedTriangles++;
+                }
+            }
+        }
+
+        if (performed == 0)
+            break;
+
+        // apply collapses and drop degenerate triangles
+        size_t write = 0;
+        for (size_t i = 0; i < result.size(); i += 3) {
+            uint32_t a = collapseTo[result[i + 0]];
+            uint32_t b = collapseTo[result[i + 1]];
+            uint32_t c = collapseTo[result[i + 2]];
+
+            if (a == b || b == c || c == a)
+                continue;
+
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+    }
+
+    if (resultError) {
+        *resultError = std::sqrt(maxError);
+    }
+
+    return result;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+namespace Engine {
+    /// @brief Triangle list simplification based on quadric error metrics
+    /// Uses half-edge collapses, so simplified triangles keep referencing the original vertices
+    /// and a whole LOD chain can share one vertex buffer
+    /// @link https://www.cs.cmu.edu/~./garland/Papers/quadrics.pdf
+    /// @link https://github.com/zeux/meshoptimizer#simplification
+    class MeshSimplifier {
+    public:
+        //! Simplifies \a indices until \a targetIndexCount is reached or the next collapse would exceed \a targetError.
+        //! Error is relative to the mesh extents, \a resultError receives the largest error introduced.
+        static std::vector<uint32_t> simplify(const std::vector<glm::vec3>& positions,
+                                              const std::vector<uint32_t>& indices,
+                                              size_t targetIndexCount,
+                                              float targetError,
+                                              float* resultError = nullptr);
+
+    private:
+        struct Quadric {
+            float a00{0}, a11{0}, a22{0};
+            float a10{0}, a20{0}, a21{0};
+            float b0{0}, b1{0}, b2{0};
+            float c{0};
+            float weight{0};
+
+            Quadric& operator+=(const Quadric& other);
+            float evaluate(const glm::vec3& point) const;
+
+            static Quadric fromPlane(const glm::vec3& normal, float distance, float weight);
+        };
+
+        struct Collapse {
+            uint32_t source;
+            uint32_t target;
+            float error;
+        };
+    };
+}
@@ -0,0 +1,193 @@
+#include "Meshlet.hpp"
+#include "../geometry/Frustum.hpp"
+#include "../geometry/Sphere.hpp"
+
+using Engine::Meshlet;
+using Engine::Frustum;
+using Engine::Sphere;
+
+bool Meshlet::isBackFacing(const glm::vec3& cameraPosition) const {
+    glm::vec3 direction = center - cameraPosition;
+    return glm::dot(direction, coneAxis) >= coneCutoff * glm::length(direction) + radius;
+}
+
+bool Meshlet::isOutside(const Frustum& frustum) const {
+    return !frustum.intersects(center, radius);
+}
+
+bool Meshlet::isVisible(const Frustum& frustum, const glm::vec3& cameraPosition) const {
+    return !isOutside(frustum) && !isBackFacing(cameraPosition);
+}
+
+std::vector<Meshlet> Meshlet::build(const std::vector<glm::vec3>& positions, uint32_t* indices, size_t indexCount, size_t maxVertices, size_t maxTriangles) {
+    assert(indexCount % 3 == 0 && "Index count must be a multiple of 3");
+    assert(maxVertices >= 3 && maxTriangles >= 1 && "Meshlet limits are too small");
+
+    size_t triangleCount = indexCount / 3;
+    size_t vertexCount = positions.size();
+
+    // vertex -> triangles adjacency, stored as offsets into a flat array
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (size_t i = 0; i < indexCount; ++i) {
+        assert(indices[i] < vertexCount && "Index out of range");
+        adjacencyOffsets[indices[i] + 1]++;
+    }
+    for (size_t i = 0; i < vertexCount; ++i) {
+        adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+    }
+
+    std::vector<uint32_t> adjacency(indexCount);
+    std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        for (size_t k = 0; k < 3; ++k) {
+            adjacency[fill[indices[t * 3 + k]]++] = static_cast<uint32_t>(t);
+        }
+    }
+
+    std::vector<Meshlet> meshlets;
+    std::vector<uint32_t> reordered;
+    reordered.reserve(indexCount);
+
+    std::vector<bool> emitted(triangleCount, false);
+    // id of the last meshlet which referenced the vertex
+    std::vector<uint32_t> vertexMeshlet(vertexCount, std::numeric_limits<uint32_t>::max());
+    std::vector<uint32_t> meshletVertices;
+    meshletVertices.reserve(maxVertices);
+    size_t meshletTriangles = 0;
+
+    auto countNewVertices = [&](size_t t) {
+        auto id = static_cast<uint32_t>(meshlets.size());
+        uint32_t a = indices[t * 3 + 0];
+        uint32_t b = indices[t * 3 + 1];
+        uint32_t c = indices[t * 3 + 2];
+        size_t count = 0;
+        count += vertexMeshlet[a] != id;
+        count += vertexMeshlet[b] != id && b != a;
+        count += vertexMeshlet[c] != id && c != a && c != b;
+        return count;
+    };
+
+    auto emitTriangle = [&](size_t t) {
+        auto id = static_cast<uint32_t>(meshlets.size());
+        for (size_t k = 0; k < 3; ++k) {
+            uint32_t v = indices[t * 3 + k];
+            if (vertexMeshlet[v] != id) {
+                vertexMeshlet[v] = id;
+                meshletVertices.push_back(v);
+            }
+            reordered.push_back(v);
+        }
+        emitted[t] = true;
+        meshletTriangles++;
+    };
+
+    auto finishMeshlet = [&]() {
+        if (meshletTriangles == 0)
+            return;
+
+        Meshlet meshlet{};
+        meshlet.indexCount = static_cast<uint32_t>(meshletTriangles * 3);
+        meshlet.indexOffset = static_cast<uint32_t>(reordered.size()) - meshlet.indexCount;
+        meshlet.vertexCount = static_cast<uint32_t>(meshletVertices.size());
+        calculateBounds(meshlet, positions, reordered.data());
+        meshlets.push_back(meshlet);
+
+        meshletVertices.clear();
+        meshletTriangles = 0;
+    };
+
+    size_t seed = 0;
+    while (true) {
+        // prefer the neighbouring triangle that adds the fewest new vertices
+        size_t best = triangleCount;
+        size_t bestScore = std::numeric_limits<size_t>::max();
+
+        for (uint32_t v : meshletVertices) {
+            for (uint32_t i = adjacencyOffsets[v]; i < adjacencyOffsets[v + 1] && bestScore > 0; ++i) {
+                uint32_t t = adjacency[i];
+                if (emitted[t])
+                    continue;
+
+                size_t score = countNewVertices(t);
+                if (score < bestScore) {
+                    best = t;
+                    bestScore = score;
+                }
+            }
+        }
+
+        // no connected triangles left, restart from the first unprocessed one
+        if (best == triangleCount) {
+            while (seed < triangleCount && emitted[seed]) {
+                ++seed;
+            }
+            if (seed == triangleCount)
+                break;
+
+            best = seed;
+            bestScore = countNewVertices(seed);
+        }
+
+        if (meshletTriangles + 1 > maxTriangles || meshletVertices.size() + bestScore > maxVertices) {
+            finishMeshlet();
+        }
+
+        emitTriangle(best);
+    }
+
+    finishMeshlet();
+
+    std::copy(reordered.begin(), reordered.end(), indices);
+
+    return meshlets;
+}
+
+void Meshlet::calculateBounds(Meshlet& meshlet, const std::vector<glm::vec3>& positions, const uint32_t* indices) {
+    const uint32_t* triangles = indices + meshlet.indexOffset;
+
+    std::vector<glm::vec3> points;
+    points.reserve(meshlet.indexCount);
+    for (uint32_t i = 0; i < meshlet.indexCount; ++i) {
+        points.push_back(positions[triangles[i]]);
+    }
+
+    Sphere sphere = Sphere::calculateBoundingSphere(points);
+    meshlet.center = sphere.getCenter();
+    meshlet.radius = sphere.getRadius();
+
+    // average normal of the cluster with the widest deviation from it
+    std::vector<glm::vec3> normals;
+    normals.reserve(meshlet.indexCount / 3);
+    glm::vec3 axis{0};
+
+    for (uint32_t i = 0; i < meshlet.indexCount; i += 3) {
+        const glm::vec3& a = points[i + 0];
+        const glm::vec3& b = points[i + 1];
+        const glm::vec3& c = points[i + 2];
+
+        glm::vec3 normal = glm::cross(b - a, c - a);
+        float length = glm::length(normal);
+        if (length > 0) {
+            normal /= length;
+            normals.push_back(normal);
+            axis += normal;
+        }
+    }
+
+    if (normals.empty() || glm::length2(axis) == 0) {
+        meshlet.coneAxis = glm::vec3{0};
+        meshlet.coneCutoff = 1;
+        return;
+    }
+
+    axis = glm::normalize(axis);
+
+    float minDot = 1;
+    for (const auto& normal : normals) {
+        minDot = std::min(minDot, glm::dot(normal, axis));
+    }
+
+    meshlet.coneAxis = axis;
+    // cone wider than a hemisphere can never be culled
+    meshlet.coneCutoff = minDot <= 0 ? 1 : std::sqrt(1 - minDot * minDot);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+namespace Engine {
+    class Frustum;
+
+    /// @brief Small cluster of triangles occupying a contiguous range of the index buffer
+    /// Bounds and normal cone are stored in the mesh local space
+    /// @link https://github.com/zeux/meshoptimizer#clusterization
+    struct Meshlet {
+        uint32_t indexOffset{0};
+        uint32_t indexCount{0};
+        uint32_t vertexCount{0};
+
+        glm::vec3 center{0};
+        float radius{0};
+
+        glm::vec3 coneAxis{0};
+        float coneCutoff{1};
+
+        //! Returns true if every triangle of the meshlet faces away from \a cameraPosition.
+        bool isBackFacing(const glm::vec3& cameraPosition) const;
+        //! Returns true if the bounding sphere of the meshlet is fully outside \a frustum.
+        bool isOutside(const Frustum& frustum) const;
+        //! Returns true if the meshlet is potentially visible.
+        bool isVisible(const Frustum& frustum, const glm::vec3& cameraPosition) const;
+
+        //! Partitions the triangle list \a indices into meshlets. Reorders \a indices so that every meshlet occupies a contiguous range.
+        static std::vector<Meshlet> build(const std::vector<glm::vec3>& positions, uint32_t* indices, size_t indexCount, size_t maxVertices = MAX_VERTICES, size_t maxTriangles = MAX_TRIANGLES);
+        //! Calculates the bounding sphere and normal cone of the triangles in the \a meshlet.
+        static void calculateBounds(Meshlet& meshlet, const std::vector<glm::vec3>& positions, const uint32_t* indices);
+
+        static constexpr size_t MAX_VERTICES = 64;
+        static constexpr size_t MAX_TRIANGLES = 124;
+    };
+}
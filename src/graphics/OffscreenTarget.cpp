@@ -0,0 +1,268 @@
+#include "OffscreenTarget.hpp"
+#include "Device.hpp"
+#include "AllocatedBuffer.hpp"
+#include "../Profiler.hpp"
+
+using Engine::OffscreenTarget;
+
+OffscreenTarget::OffscreenTarget(Device& device, vk::Extent2D extent, const RenderSettings& settings) : device{device}, extent{extent}, settings{settings} {
+    depthFormat = findDepthFormat();
+    if (!settings.dynamicRendering) {
+        createRenderPass();
+    }
+    createDepthResources();
+    createFrames();
+}
+
+OffscreenTarget::~OffscreenTarget() {
+    // nothing waits before the renderer goes away, frames may still be in flight,
+    // everything goes once the submissions made so far have completed
+    auto& deletionQueue = device.getDeletionQueue();
+
+    for (const auto& frame : frames) {
+        if (frame.framebuffer) {
+            deletionQueue.push(frame.framebuffer);
+        }
+        deletionQueue.push(frame.colorImageView);
+        deletionQueue.push(frame.colorImage);
+        deletionQueue.push(frame.colorImageMemory);
+    }
+
+    deletionQueue.push(depthImageView);
+    deletionQueue.push(depthImage);
+    deletionQueue.push(depthImageMemory);
+
+    if (renderPass) {
+        deletionQueue.push(renderPass);
+    }
+}
+
+void OffscreenTarget::createRenderPass() {
+    // same attachments as the swap chain pass, only the final color layout differs
+    vk::AttachmentDescription colorAttachment{};
+    colorAttachment.format = COLOR_FORMAT;
+    colorAttachment.samples = vk::SampleCountFlagBits::e1;
+    colorAttachment.loadOp = vk::AttachmentLoadOp::eClear;
+    colorAttachment.storeOp = vk::AttachmentStoreOp::eStore;
+    colorAttachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
+    colorAttachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
+    colorAttachment.initialLayout = vk::ImageLayout::eUndefined;
+    colorAttachment.finalLayout = vk::ImageLayout::eColorAttachmentOptimal;
+
+    vk::AttachmentDescription depthAttachment{};
+    depthAttachment.format = depthFormat;
+    depthAttachment.samples = vk::SampleCountFlagBits::e1;
+    depthAttachment.loadOp = vk::AttachmentLoadOp::eClear;
+    depthAttachment.storeOp = vk::AttachmentStoreOp::eDontCare;
+    depthAttachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
+    depthAttachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
+    depthAttachment.initialLayout = vk::ImageLayout::eUndefined;
+    depthAttachment.finalLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+
+    vk::AttachmentReference colorAttachmentRef{};
+    colorAttachmentRef.attachment = 0;
+    colorAttachmentRef.layout = vk::ImageLayout::eColorAttachmentOptimal;
+
+    vk::AttachmentReference depthAttachmentRef{};
+    depthAttachmentRef.attachment = 1;
+    depthAttachmentRef.layout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+
+    vk::SubpassDescription subpass{};
+    subpass.pipelineBindPoint = vk::PipelineBindPoint::eGraphics;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &colorAttachmentRef;
+    subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+    vk::SubpassDependency dependency{};
+    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependency.dstSubpass = 0;
+    // the depth image is shared by all frames, so the depth writes of the previous frame have to finish first
+    dependency.srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests;
+    dependency.srcAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+    dependency.dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests;
+    dependency.dstAccessMask = vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+
+    std::array<vk::AttachmentDescription, 2> attachments = {colorAttachment, depthAttachment};
+    vk::RenderPassCreateInfo renderPassInfo{};
+    renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+    renderPassInfo.pAttachments = attachments.data();
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpass;
+    renderPassInfo.dependencyCount = 1;
+    renderPassInfo.pDependencies = &dependency;
+
+    try {
+        renderPass = device.getLogical().createRenderPass(renderPassInfo);
+    } catch (vk::SystemError& err) {
+        throw std::runtime_error("failed to create render pass!");
+    }
+}
+
+void OffscreenTarget::createDepthResources() {
+    device.createImage(extent.width, extent.height, depthFormat, vk::ImageTiling::eOptimal,
+                       vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eTransientAttachment,
+                       vk::MemoryPropertyFlagBits::eDeviceLocal | vk::MemoryPropertyFlagBits::eLazilyAllocated,
+                       depthImage, depthImageMemory);
+    depthImageView = device.createImageView(depthImage, depthFormat, vk::ImageAspectFlagBits::eDepth);
+}
+
+void OffscreenTarget::createFrames() {
+    frames.resize(settings.framesInFlight);
+
+    vk::ImageUsageFlags colorUsage = vk::ImageUsageFlagBits::eColorAttachment;
+    if (settings.readback) {
+        colorUsage |= vk::ImageUsageFlagBits::eTransferSrc;
+    }
+
+    for (auto& frame : frames) {
+        device.createImage(extent.width, extent.height, COLOR_FORMAT, vk::ImageTiling::eOptimal, colorUsage,
+                           vk::MemoryPropertyFlagBits::eDeviceLocal, frame.colorImage, frame.colorImageMemory);
+        frame.colorImageView = device.createImageView(frame.colorImage, COLOR_FORMAT, vk::ImageAspectFlagBits::eColor);
+
+
+        if (renderPass) {
+            std::array<vk::ImageView, 2> attachments = {
+                frame.colorImageView,
+                depthImageView
+            };
+
+            vk::FramebufferCreateInfo framebufferInfo{};
+            framebufferInfo.renderPass = renderPass;
+            framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+            framebufferInfo.pAttachments = attachments.data();
+            framebufferInfo.width = extent.width;
+            framebufferInfo.height = extent.height;
+            framebufferInfo.layers = 1;
+
+            try {
+                frame.framebuffer = device.getLogical().createFramebuffer(framebufferInfo);
+            } catch (vk::SystemError& err) {
+                throw std::runtime_error("failed to create framebuffer!");
+            }
+        }
+
+        if (settings.readback) {
+            frame.readbackBuffer = std::make_unique<AllocatedBuffer>(
+                device,
+                4,
+                extent.width * extent.height,
+                vk::BufferUsageFlagBits::eTransferDst,
+                vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+            frame.readbackBuffer->map();
+        }
+    }
+}
+
+vk::Format OffscreenTarget::findDepthFormat() const {
+    return device.findSupportedFormat({
+        vk::Format::eD32Sfloat,
+        vk::Format::eD32SfloatS8Uint,
+        vk::Format::eD24UnormS8Uint
+    },
+    vk::ImageTiling::eOptimal,
+    vk::FormatFeatureFlagBits::eDepthStencilAttachment);
+}
+
+vk::Result OffscreenTarget::acquireNextImage(uint32_t& imageIndex) const {
+    PROFILE_SCOPE("OffscreenTarget::acquireNextImage");
+
+    device.waitTimeline(frames[currentFrame].timelineValue);
+
+    device.getDeletionQueue().collect(device.getCompletedTimelineValue());
+
+    imageIndex = currentFrame;
+    return vk::Result::eSuccess;
+}
+
+void OffscreenTarget::recordFrameEnd(const vk::CommandBuffer& commandBuffer, uint32_t imageIndex) {
+    if (!settings.readback)
+        return;
+
+    auto& frame = frames[imageIndex];
+
+    vk::ImageMemoryBarrier barrier{};
+    barrier.srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite;
+    barrier.dstAccessMask = vk::AccessFlagBits::eTransferRead;
+    barrier.oldLayout = vk::ImageLayout::eColorAttachmentOptimal;
+    barrier.newLayout = vk::ImageLayout::eTransferSrcOptimal;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = frame.colorImage;
+    barrier.subresourceRange = {vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1};
+
+    commandBuffer.pipelineBarrier(
+        vk::PipelineStageFlagBits::eColorAttachmentOutput,
+        vk::PipelineStageFlagBits::eTransfer,
+        vk::DependencyFlags(),
+        0, nullptr,
+        0, nullptr,
+        1, &barrier);
+
+    vk::BufferImageCopy region{};
+    region.imageSubresource = {vk::ImageAspectFlagBits::eColor, 0, 0, 1};
+    region.imageExtent = vk::Extent3D{extent.width, extent.height, 1};
+
+    commandBuffer.copyImageToBuffer(frame.colorImage, vk::ImageLayout::eTransferSrcOptimal, frame.readbackBuffer->get(), 1, &region);
+
+    // make the copy visible to the host once the timeline value is reached
+    vk::BufferMemoryBarrier hostBarrier{};
+    hostBarrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+    hostBarrier.dstAccessMask = vk::AccessFlagBits::eHostRead;
+    hostBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    hostBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    hostBarrier.buffer = frame.readbackBuffer->get();
+    hostBarrier.offset = 0;
+    hostBarrier.size = VK_WHOLE_SIZE;
+
+    commandBuffer.pipelineBarrier(
+        vk::PipelineStageFlagBits::eTransfer,
+        vk::PipelineStageFlagBits::eHost,
+        vk::DependencyFlags(),
+        0, nullptr,
+        1, &hostBarrier,
+        0, nullptr);
+}
+
+vk::Result OffscreenTarget::submitCommandBuffers(const vk::CommandBuffer& buffers, const uint32_t& imageIndex) {
+    PROFILE_SCOPE("OffscreenTarget::submitCommandBuffers");
+
+    uint64_t value = device.nextTimelineValue();
+
+    vk::TimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues = &value;
+
+    vk::SubmitInfo submitInfo{};
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &buffers;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &device.getTimelineSemaphore();
+
+    try {
+        device.getGraphicsQueue().submit(submitInfo, nullptr);
+    } catch (vk::SystemError& err) {
+        throw std::runtime_error("failed to submit draw command buffer!");
+    }
+
+    frames[imageIndex].timelineValue = value;
+    device.getDeletionQueue().retire(value);
+
+    lastSubmittedFrame = imageIndex;
+    currentFrame = (currentFrame + 1) % settings.framesInFlight;
+
+    return vk::Result::eSuccess;
+}
+
+void OffscreenTarget::readPixels(std::vector<uint8_t>& pixels) {
+    assert(settings.readback && "Readback is not enabled in the render settings");
+
+    auto& frame = frames[lastSubmittedFrame];
+    assert(frame.timelineValue > 0 && "No frame has been submitted yet");
+
+    device.waitTimeline(frame.timelineValue);
+
+    auto size = static_cast<size_t>(extent.width) * extent.height * 4;
+    const auto* data = static_cast<const uint8_t*>(frame.readbackBuffer->getMappedMemory());
+    pixels.assign(data, data + size);
+}
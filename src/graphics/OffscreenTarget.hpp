@@ -0,0 +1,72 @@
+#pragma once
+
+#include "RenderTarget.hpp"
+#include "RenderSettings.hpp"
+
+namespace Engine {
+    class Device;
+    class AllocatedBuffer;
+
+    /// @brief Color and depth images to render into without a window, for headless runs
+    /// Every frame in flight has its own color image, the image index is the frame slot.
+    /// Depth is transient and shared, like the swap chain depth image.
+    /// With readback enabled the color image of each frame is copied into host visible memory.
+    class OffscreenTarget : public RenderTarget {
+    public:
+        //! Matches the format the swap chain prefers, so the render passes stay compatible.
+        static constexpr vk::Format COLOR_FORMAT = vk::Format::eB8G8R8A8Unorm;
+
+        OffscreenTarget(Device& device, vk::Extent2D extent, const RenderSettings& settings);
+        ~OffscreenTarget() override;
+        OffscreenTarget(const OffscreenTarget&) = delete;
+        OffscreenTarget(OffscreenTarget&&) = delete;
+        OffscreenTarget& operator=(const OffscreenTarget&) = delete;
+        OffscreenTarget& operator=(OffscreenTarget&&) = delete;
+
+        const vk::RenderPass& getRenderPass() const override { return renderPass; };
+        const vk::Framebuffer& getFrameBuffer(size_t index) const override { return frames[index].framebuffer; };
+        Attachments getAttachments(size_t index) const override { return {frames[index].colorImage, frames[index].colorImageView, depthImage, depthImageView}; };
+        const vk::Extent2D& getExtent() const override { return extent; };
+        vk::Format getColorFormat() const override { return COLOR_FORMAT; };
+        vk::Format getDepthFormat() const override { return depthFormat; };
+        vk::ImageLayout getFinalColorLayout() const override { return vk::ImageLayout::eColorAttachmentOptimal; };
+
+        vk::Result acquireNextImage(uint32_t& imageIndex) const override;
+        void recordFrameEnd(const vk::CommandBuffer& commandBuffer, uint32_t imageIndex) override;
+        vk::Result submitCommandBuffers(const vk::CommandBuffer& buffers, const uint32_t& imageIndex) override;
+
+        //! Waits for the last submitted frame and copies its color image into \a pixels, tightly packed BGRA rows.
+        void readPixels(std::vector<uint8_t>& pixels);
+
+    private:
+        struct Frame {
+            vk::Image colorImage;
+            vk::DeviceMemory colorImageMemory;
+            vk::ImageView colorImageView;
+            vk::Framebuffer framebuffer;
+            std::unique_ptr<AllocatedBuffer> readbackBuffer;
+            //! Timeline value signaled by the last submission of this frame slot.
+            uint64_t timelineValue{0};
+        };
+
+        void createRenderPass();
+        void createDepthResources();
+        void createFrames();
+
+        vk::Format findDepthFormat() const;
+
+        Device& device;
+        vk::Extent2D extent;
+        RenderSettings settings;
+        vk::Format depthFormat;
+        vk::RenderPass renderPass;
+
+        vk::Image depthImage;
+        vk::DeviceMemory depthImageMemory;
+        vk::ImageView depthImageView;
+
+        std::vector<Frame> frames;
+        uint32_t currentFrame{0};
+        uint32_t lastSubmittedFrame{0};
+    };
+}
@@ -1,39 +1,53 @@
 #include "Pipeline.hpp"
 #include "Device.hpp"
 #include "Mesh.hpp"
+#include "Shaders.hpp"
 
 using Engine::Pipeline;
 using Engine::PipelineConfigInfo;
 
-Pipeline::Pipeline(Device& device, const std::string& vertPath, const std::string& fragPath, const PipelineConfigInfo& configInfo) : device{device} {
-    createGraphicsPipeline(vertPath, fragPath, configInfo);
-}
+Pipeline::Pipeline(Device& device, const std::string& vertShader, const std::string& fragShader, const PipelineConfigInfo& configInfo) : device{device} {
+    vk::ShaderModule vertShaderModule = createShaderModule(device, Shaders::load(vertShader));
+    vk::ShaderModule fragShaderModule = createShaderModule(device, Shaders::load(fragShader));
+
+    // modules are only needed while the pipeline is created
+    try {
+        createGraphicsPipeline(vertShaderModule, fragShaderModule, configInfo);
+    } catch (...) {
+        device.getLogical().destroyShaderModule(vertShaderModule);
+        device.getLogical().destroyShaderModule(fragShaderModule);
+        throw;
+    }
 
-Pipeline::~Pipeline() {
     device.getLogical().destroyShaderModule(vertShaderModule);
     device.getLogical().destroyShaderModule(fragShaderModule);
-    device.getLogical().destroyPipeline(graphicsPipeline);
 }
 
-void Pipeline::createGraphicsPipeline(const std::string& vertPath, const std::string& fragPath, const PipelineConfigInfo& configInfo) {
-    auto vertShaderCode = readFile(vertPath);
-    auto fragShaderCode = readFile(fragPath);
+Pipeline::Pipeline(Device& device, const vk::ShaderModule& vertShaderModule, const vk::ShaderModule& fragShaderModule, const PipelineConfigInfo& configInfo) : device{device} {
+    createGraphicsPipeline(vertShaderModule, fragShaderModule, configInfo);
+}
+
+Pipeline::~Pipeline() {
+    device.getDeletionQueue().push(graphicsPipeline);
+}
 
-    vertShaderModule = createShaderModule(vertShaderCode);
-    fragShaderModule = createShaderModule(fragShaderCode);
+void Pipeline::createGraphicsPipeline(const vk::ShaderModule& vertShaderModule, const vk::ShaderModule& fragShaderModule, const PipelineConfigInfo& configInfo) {
+    const vk::SpecializationInfo* specializationInfo = configInfo.specializationInfo.mapEntryCount > 0 ? &configInfo.specializationInfo : nullptr;
 
     vk::PipelineShaderStageCreateInfo shaderStages[] = {
         {
             vk::PipelineShaderStageCreateFlags(),
             vk::ShaderStageFlagBits::eVertex,
             vertShaderModule,
-            "main"
+            "main",
+            specializationInfo
         },
         {
             vk::PipelineShaderStageCreateFlags(),
             vk::ShaderStageFlagBits::eFragment,
             fragShaderModule,
-            "main"
+            "main",
+            specializationInfo
         }
     };
 
@@ -61,43 +75,33 @@ void Pipeline::createGraphicsPipeline(const std::string& vertPath, const std::st
     pipelineInfo.subpass = configInfo.subpass;
     pipelineInfo.basePipelineHandle = nullptr;
 
-    auto pipeline = device.getLogical().createGraphicsPipeline(nullptr, pipelineInfo);
+    vk::PipelineRenderingCreateInfo renderingInfo{};
+    if (!configInfo.renderPass) {
+        renderingInfo.colorAttachmentCount = 1;
+        renderingInfo.pColorAttachmentFormats = &configInfo.colorAttachmentFormat;
+        renderingInfo.depthAttachmentFormat = configInfo.depthAttachmentFormat;
+        pipelineInfo.pNext = &renderingInfo;
+    }
+
+    auto pipeline = device.getLogical().createGraphicsPipeline(device.getPipelineCache(), pipelineInfo);
     if (pipeline.result != vk::Result::eSuccess) {
         throw std::runtime_error("failed to create pipeline layout!");
     }
     graphicsPipeline = pipeline.value;
 }
 
-vk::ShaderModule Pipeline::createShaderModule(const std::vector<char>& code) {
+vk::ShaderModule Pipeline::createShaderModule(const Device& device, const std::vector<uint32_t>& code) {
     try {
         return device.getLogical().createShaderModule({
             vk::ShaderModuleCreateFlags(),
-            code.size(),
-            reinterpret_cast<const uint32_t*>(code.data())
+            code.size() * sizeof(uint32_t),
+            code.data()
         });
     } catch (vk::SystemError& err) {
         throw std::runtime_error("failed to create shader module!");
     }
 }
 
-std::vector<char> Pipeline::readFile(const std::string& path) {
-    std::ifstream file {path, std::ios::ate | std::ios::binary};
-
-    if (!file.is_open()) {
-        throw std::runtime_error("Failed to open file: " + path);
-    }
-
-    size_t size = static_cast<size_t>(file.tellg());
-    std::vector<char> buffer(size);
-
-    file.seekg(0);
-    file.read(buffer.data(), size);
-
-    file.close();
-
-    return buffer;
-}
-
 void Pipeline::bind(const vk::CommandBuffer& commandBuffer) const {
     commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, graphicsPipeline);
 }
@@ -148,3 +152,19 @@ void Pipeline::defaultPipelineConfigInfo(PipelineConfigInfo& configInfo) {
     configInfo.bindingDescriptions = Mesh::Vertex::getBindingDescriptions();
     configInfo.attributeDescriptions = Mesh::Vertex::getAttributeDescriptions();
 }
+
+void Pipeline::specializeFeatures(PipelineConfigInfo& configInfo, ShaderFeatureFlags features) {
+    configInfo.specializationEntries.clear();
+    configInfo.specializationData.resize(Shaders::FEATURE_COUNT * sizeof(vk::Bool32));
+
+    for (uint32_t i = 0; i < Shaders::FEATURE_COUNT; i++) {
+        vk::Bool32 enabled = (features >> i) & 1 ? VK_TRUE : VK_FALSE;
+        std::memcpy(configInfo.specializationData.data() + i * sizeof(vk::Bool32), &enabled, sizeof(vk::Bool32));
+        configInfo.specializationEntries.emplace_back(i, i * static_cast<uint32_t>(sizeof(vk::Bool32)), sizeof(vk::Bool32));
+    }
+
+    configInfo.specializationInfo.mapEntryCount = static_cast<uint32_t>(configInfo.specializationEntries.size());
+    configInfo.specializationInfo.pMapEntries = configInfo.specializationEntries.data();
+    configInfo.specializationInfo.dataSize = configInfo.specializationData.size();
+    configInfo.specializationInfo.pData = configInfo.specializationData.data();
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "Shaders.hpp"
+
 namespace Engine {
     class Device;
 
@@ -22,16 +24,28 @@ namespace Engine {
         vk::PipelineDepthStencilStateCreateInfo depthStencilInfo{};
         std::vector<vk::DynamicState> dynamicStateEnables{};
         vk::PipelineDynamicStateCreateInfo dynamicStateInfo{};
+        //! Specialization constants, shared by both shader stages.
+        std::vector<vk::SpecializationMapEntry> specializationEntries{};
+        std::vector<uint8_t> specializationData{};
+        vk::SpecializationInfo specializationInfo{};
         vk::PipelineLayout pipelineLayout{nullptr};
         vk::RenderPass renderPass{nullptr};
         uint32_t subpass{0};
+        //! Attachment formats for dynamic rendering, used when there is no render pass.
+        vk::Format colorAttachmentFormat{vk::Format::eUndefined};
+        vk::Format depthAttachmentFormat{vk::Format::eUndefined};
     };
 
     class Pipeline {
     public:
         Pipeline(Device& device,
-                 const std::string& vertPath,
-                 const std::string& fragPath,
+                 const std::string& vertShader,
+                 const std::string& fragShader,
+                 const PipelineConfigInfo& configInfo);
+        //! Builds the pipeline from shader modules owned by the caller.
+        Pipeline(Device& device,
+                 const vk::ShaderModule& vertShaderModule,
+                 const vk::ShaderModule& fragShaderModule,
                  const PipelineConfigInfo& configInfo);
         ~Pipeline();
         Pipeline(const Pipeline&) = delete;
@@ -41,16 +55,17 @@ namespace Engine {
 
         void bind(const vk::CommandBuffer& commandBuffer) const;
 
+        const vk::Pipeline& getHandle() const { return graphicsPipeline; };
+
         static void defaultPipelineConfigInfo(PipelineConfigInfo& configInfo);
+        //! Sets one boolean specialization constant per shader feature, disabled branches are compiled out.
+        static void specializeFeatures(PipelineConfigInfo& configInfo, ShaderFeatureFlags features);
+        static vk::ShaderModule createShaderModule(const Device& device, const std::vector<uint32_t>& code);
+
     private:
         Device& device;
-        vk::ShaderModule vertShaderModule;
-        vk::ShaderModule fragShaderModule;
         vk::Pipeline graphicsPipeline;
 
-        vk::ShaderModule createShaderModule(const std::vector<char>& code);
-        void createGraphicsPipeline(const std::string& vertPath, const std::string& fragPath, const PipelineConfigInfo& configInfo);
-
-        static std::vector<char> readFile(const std::string& path);
+        void createGraphicsPipeline(const vk::ShaderModule& vertShaderModule, const vk::ShaderModule& fragShaderModule, const PipelineConfigInfo& configInfo);
     };
 }
@@ -0,0 +1,90 @@
+#include "PipelineCompiler.hpp"
+#include "Pipeline.hpp"
+#include "../Profiler.hpp"
+
+using Engine::PipelineCompiler;
+using Engine::Pipeline;
+
+PipelineCompiler::PipelineCompiler(Device& device, uint32_t threadCount) : device{device} {
+    if (threadCount == 0) {
+        threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+
+    workers.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; i++) {
+        workers.emplace_back(&PipelineCompiler::work, this);
+    }
+}
+
+PipelineCompiler::~PipelineCompiler() {
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        stopping = true;
+    }
+    condition.notify_all();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+PipelineCompiler::Future PipelineCompiler::compile(std::unique_ptr<PipelineConfigInfo> configInfo, std::string vertShader, std::string fragShader) {
+    assert(configInfo && "Pipeline config cannot be null");
+
+    return push({std::move(configInfo), std::move(vertShader), std::move(fragShader), nullptr, nullptr, {}});
+}
+
+PipelineCompiler::Future PipelineCompiler::compile(std::unique_ptr<PipelineConfigInfo> configInfo, vk::ShaderModule vertShaderModule, vk::ShaderModule fragShaderModule) {
+    assert(configInfo && "Pipeline config cannot be null");
+    assert(vertShaderModule && fragShaderModule && "Shader modules cannot be null");
+
+    return push({std::move(configInfo), {}, {}, vertShaderModule, fragShaderModule, {}});
+}
+
+PipelineCompiler::Future PipelineCompiler::push(Task&& task) {
+    Future future = task.promise.get_future().share();
+
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        tasks.push_back(std::move(task));
+    }
+    condition.notify_one();
+
+    return future;
+}
+
+std::shared_ptr<Pipeline> PipelineCompiler::poll(const Future& future) {
+    if (!future.valid() || future.wait_for(std::chrono::seconds{0}) != std::future_status::ready)
+        return nullptr;
+
+    return future.get();
+}
+
+void PipelineCompiler::work() {
+    PROFILE_THREAD("pipeline compiler");
+
+    while (true) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock{mutex};
+            condition.wait(lock, [this] { return stopping || !tasks.empty(); });
+            // pending requests are dropped, their futures report a broken promise
+            if (stopping)
+                return;
+
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+
+        PROFILE_SCOPE("PipelineCompiler::compile");
+        try {
+            if (task.vertShaderModule) {
+                task.promise.set_value(std::make_shared<Pipeline>(device, task.vertShaderModule, task.fragShaderModule, *task.configInfo));
+            } else {
+                task.promise.set_value(std::make_shared<Pipeline>(device, task.vertShader, task.fragShader, *task.configInfo));
+            }
+        } catch (...) {
+            task.promise.set_exception(std::current_exception());
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+namespace Engine {
+    class Device;
+    class Pipeline;
+    struct PipelineConfigInfo;
+
+    /// @brief Builds pipelines on background threads
+    /// Requests are queued and picked up by a fixed set of workers, the pipeline cache of the device is shared between them
+    class PipelineCompiler {
+    public:
+        using Future = std::shared_future<std::shared_ptr<Pipeline>>;
+
+        //! Starts \a threadCount workers, zero picks one less than the number of hardware threads.
+        explicit PipelineCompiler(Device& device, uint32_t threadCount = 0);
+        ~PipelineCompiler();
+        PipelineCompiler(const PipelineCompiler&) = delete;
+        PipelineCompiler(PipelineCompiler&&) = delete;
+        PipelineCompiler& operator=(const PipelineCompiler&) = delete;
+        PipelineCompiler& operator=(PipelineCompiler&&) = delete;
+
+        //! Queues a pipeline build. \a configInfo is owned by the request, so its internal pointers stay valid until it finishes.
+        Future compile(std::unique_ptr<PipelineConfigInfo> configInfo, std::string vertShader, std::string fragShader);
+        //! Queues a pipeline build from shader modules, which must stay alive until it finishes.
+        Future compile(std::unique_ptr<PipelineConfigInfo> configInfo, vk::ShaderModule vertShaderModule, vk::ShaderModule fragShaderModule);
+
+        //! Returns the pipeline if \a future has finished, nullptr otherwise. Rethrows compilation errors.
+        static std::shared_ptr<Pipeline> poll(const Future& future);
+
+    private:
+        struct Task {
+            std::unique_ptr<PipelineConfigInfo> configInfo;
+            std::string vertShader;
+            std::string fragShader;
+            vk::ShaderModule vertShaderModule;
+            vk::ShaderModule fragShaderModule;
+            std::promise<std::shared_ptr<Pipeline>> promise;
+        };
+
+        Future push(Task&& task);
+        void work();
+
+        Device& device;
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::deque<Task> tasks;
+        bool stopping{false};
+    };
+}
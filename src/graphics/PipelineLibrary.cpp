@@ -0,0 +1,235 @@
+#include "PipelineLibrary.hpp"
+#include "PipelineCompiler.hpp"
+#include "Pipeline.hpp"
+#include "Device.hpp"
+#include "Shaders.hpp"
+
+#include <chrono>
+
+using Engine::PipelineLibrary;
+using Engine::PipelineConfigInfo;
+
+namespace {
+    template<typename T>
+    void append(std::string& key, const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "Key fields must be trivially copyable");
+        key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void append(std::string& key, const vk::StencilOpState& state) {
+        append(key, state.failOp);
+        append(key, state.passOp);
+        append(key, state.depthFailOp);
+        append(key, state.compareOp);
+        append(key, state.compareMask);
+        append(key, state.writeMask);
+        append(key, state.reference);
+    }
+
+    void append(std::string& key, const vk::PipelineColorBlendAttachmentState& state) {
+        append(key, state.blendEnable);
+        append(key, state.srcColorBlendFactor);
+        append(key, state.dstColorBlendFactor);
+        append(key, state.colorBlendOp);
+        append(key, state.srcAlphaBlendFactor);
+        append(key, state.dstAlphaBlendFactor);
+        append(key, state.alphaBlendOp);
+        append(key, static_cast<VkColorComponentFlags>(state.colorWriteMask));
+    }
+}
+
+PipelineLibrary::PipelineLibrary(Device& device, PipelineCompiler& compiler) : device{device}, compiler{compiler} {
+}
+
+PipelineLibrary::~PipelineLibrary() {
+    // queued builds still reference the shared modules
+    for (const auto& [key, entry] : pipelines) {
+        entry.future.wait();
+    }
+    for (const auto& future : evicted) {
+        future.wait();
+    }
+
+    for (const auto& [hash, shaderModule] : shaderModules) {
+        device.getLogical().destroyShaderModule(shaderModule.module);
+    }
+}
+
+PipelineLibrary::Future PipelineLibrary::getPipeline(std::unique_ptr<PipelineConfigInfo> configInfo, const std::string& vertShader, const std::string& fragShader) {
+    assert(configInfo && "Pipeline config cannot be null");
+
+    vk::ShaderModule vertShaderModule = getShaderModule(vertShader);
+    vk::ShaderModule fragShaderModule = getShaderModule(fragShader);
+
+    std::string key = createKey(*configInfo, vertShaderModule, fragShaderModule);
+
+    std::lock_guard<std::mutex> lock{mutex};
+    if (auto it = pipelines.find(key); it != pipelines.end())
+        return it->second.future;
+
+    vk::PipelineLayout layout = configInfo->pipelineLayout;
+    Future future = compiler.compile(std::move(configInfo), vertShaderModule, fragShaderModule);
+    pipelines.emplace(std::move(key), Entry{future, layout});
+    return future;
+}
+
+vk::ShaderModule PipelineLibrary::getShaderModule(const std::string& name) {
+    auto code = Shaders::load(name);
+    uint64_t hash = hashCode(code);
+
+    std::lock_guard<std::mutex> lock{mutex};
+    // the hash only narrows the search, a collision must not hand out another shader
+    auto [first, last] = shaderModules.equal_range(hash);
+    for (auto it = first; it != last; ++it) {
+        if (it->second.code == code)
+            return it->second.module;
+    }
+
+    vk::ShaderModule module = Pipeline::createShaderModule(device, code);
+    shaderModules.emplace(hash, ShaderModule{std::move(code), module});
+    return module;
+}
+
+void PipelineLibrary::evict(vk::PipelineLayout layout) {
+    std::lock_guard<std::mutex> lock{mutex};
+
+    // builds that are still queued keep using the shader modules
+    evicted.erase(std::remove_if(evicted.begin(), evicted.end(), [](const Future& future) {
+        return future.wait_for(std::chrono::seconds{0}) == std::future_status::ready;
+    }), evicted.end());
+
+    for (auto it = pipelines.begin(); it != pipelines.end();) {
+        if (it->second.layout == layout) {
+            evicted.push_back(it->second.future);
+            it = pipelines.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+size_t PipelineLibrary::getPipelineCount() const {
+    std::lock_guard<std::mutex> lock{mutex};
+    return pipelines.size();
+}
+
+size_t PipelineLibrary::getShaderModuleCount() const {
+    std::lock_guard<std::mutex> lock{mutex};
+    return shaderModules.size();
+}
+
+std::string PipelineLibrary::createKey(const PipelineConfigInfo& configInfo, vk::ShaderModule vertModule, vk::ShaderModule fragModule) {
+    std::string key;
+    key.reserve(512);
+
+    // modules are unique per code and live as long as the library
+    append(key, static_cast<VkShaderModule>(vertModule));
+    append(key, static_cast<VkShaderModule>(fragModule));
+
+    // fields are written one by one, create info structs carry padding and pNext pointers
+    append(key, static_cast<uint32_t>(configInfo.bindingDescriptions.size()));
+    for (const auto& binding : configInfo.bindingDescriptions) {
+        append(key, binding.binding);
+        append(key, binding.stride);
+        append(key, binding.inputRate);
+    }
+
+    append(key, static_cast<uint32_t>(configInfo.attributeDescriptions.size()));
+    for (const auto& attribute : configInfo.attributeDescriptions) {
+        append(key, attribute.location);
+        append(key, attribute.binding);
+        append(key, attribute.format);
+        append(key, attribute.offset);
+    }
+
+    const auto& inputAssembly = configInfo.inputAssemblyInfo;
+    append(key, inputAssembly.topology);
+    append(key, inputAssembly.primitiveRestartEnable);
+
+    // viewports and scissors are dynamic, only their count is baked in
+    append(key, configInfo.viewportInfo.viewportCount);
+    append(key, configInfo.viewportInfo.scissorCount);
+
+    const auto& rasterization = configInfo.rasterizationInfo;
+    append(key, rasterization.depthClampEnable);
+    append(key, rasterization.rasterizerDiscardEnable);
+    append(key, rasterization.polygonMode);
+    append(key, static_cast<VkCullModeFlags>(rasterization.cullMode));
+    append(key, rasterization.frontFace);
+    append(key, rasterization.depthBiasEnable);
+    append(key, rasterization.depthBiasConstantFactor);
+    append(key, rasterization.depthBiasClamp);
+    append(key, rasterization.depthBiasSlopeFactor);
+    append(key, rasterization.lineWidth);
+
+    const auto& multisample = configInfo.multisampleInfo;
+    assert(!multisample.pSampleMask && "Sample masks are not part of the pipeline key");
+    append(key, multisample.rasterizationSamples);
+    append(key, multisample.sampleShadingEnable);
+    append(key, multisample.minSampleShading);
+    append(key, multisample.alphaToCoverageEnable);
+    append(key, multisample.alphaToOneEnable);
+
+    const auto& colorBlend = configInfo.colorBlendInfo;
+    append(key, colorBlend.logicOpEnable);
+    append(key, colorBlend.logicOp);
+    append(key, colorBlend.attachmentCount);
+    for (uint32_t i = 0; i < colorBlend.attachmentCount; i++) {
+        append(key, colorBlend.pAttachments[i]);
+    }
+    for (float constant : colorBlend.blendConstants) {
+        append(key, constant);
+    }
+
+    const auto& depthStencil = configInfo.depthStencilInfo;
+    append(key, depthStencil.depthTestEnable);
+    append(key, depthStencil.depthWriteEnable);
+    append(key, depthStencil.depthCompareOp);
+    append(key, depthStencil.depthBoundsTestEnable);
+    append(key, depthStencil.stencilTestEnable);
+    append(key, depthStencil.front);
+    append(key, depthStencil.back);
+    append(key, depthStencil.minDepthBounds);
+    append(key, depthStencil.maxDepthBounds);
+
+    const auto& dynamicState = configInfo.dynamicStateInfo;
+    append(key, dynamicState.dynamicStateCount);
+    for (uint32_t i = 0; i < dynamicState.dynamicStateCount; i++) {
+        append(key, dynamicState.pDynamicStates[i]);
+    }
+
+    // every permutation of a shader gets its own pipeline
+    const auto& specialization = configInfo.specializationInfo;
+    append(key, specialization.mapEntryCount);
+    for (uint32_t i = 0; i < specialization.mapEntryCount; i++) {
+        append(key, specialization.pMapEntries[i].constantID);
+        append(key, specialization.pMapEntries[i].offset);
+        append(key, static_cast<uint64_t>(specialization.pMapEntries[i].size));
+    }
+    append(key, static_cast<uint64_t>(specialization.dataSize));
+    if (specialization.dataSize > 0)
+        key.append(static_cast<const char*>(specialization.pData), specialization.dataSize);
+
+    // layouts are evicted with their pipelines before the handle can be reused
+    append(key, static_cast<VkPipelineLayout>(configInfo.pipelineLayout));
+
+    // a pipeline works with every render pass compatible with its own, so the pass is keyed by what makes it
+    // compatible instead of its handle, which a recreated swap chain may reuse for a different pass
+    assert((!configInfo.renderPass || configInfo.colorAttachmentFormat != vk::Format::eUndefined) && "Render pass pipelines need their attachment formats for the key");
+    append(key, static_cast<uint32_t>(configInfo.renderPass ? 1 : 0));
+    append(key, configInfo.subpass);
+    append(key, configInfo.colorAttachmentFormat);
+    append(key, configInfo.depthAttachmentFormat);
+
+    return key;
+}
+
+uint64_t PipelineLibrary::hashCode(const std::vector<uint32_t>& code) {
+    // FNV-1a over words, SPIR-V is always word aligned
+    uint64_t hash = 14695981039346656037ull;
+    for (uint32_t word : code) {
+        hash ^= word;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
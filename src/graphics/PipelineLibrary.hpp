@@ -0,0 +1,59 @@
+#pragma once
+
+namespace Engine {
+    class Device;
+    class Pipeline;
+    class PipelineCompiler;
+    struct PipelineConfigInfo;
+
+    /// @brief Deduplicates shader modules and pipelines
+    /// Shader modules are shared by their SPIR-V, pipelines by a key serialized from the full fixed function state,
+    /// the shader modules, the layout and the attachment formats. Identical requests return the same pipeline, including ones still compiling.
+    /// Owners of a pipeline layout evict it before destroying it, so a new layout with the same handle never gets stale pipelines.
+    class PipelineLibrary {
+    public:
+        using Future = std::shared_future<std::shared_ptr<Pipeline>>;
+
+        PipelineLibrary(Device& device, PipelineCompiler& compiler);
+        ~PipelineLibrary();
+        PipelineLibrary(const PipelineLibrary&) = delete;
+        PipelineLibrary(PipelineLibrary&&) = delete;
+        PipelineLibrary& operator=(const PipelineLibrary&) = delete;
+        PipelineLibrary& operator=(PipelineLibrary&&) = delete;
+
+        //! Returns the pipeline built from the same state, queues a compilation on a miss.
+        Future getPipeline(std::unique_ptr<PipelineConfigInfo> configInfo, const std::string& vertShader, const std::string& fragShader);
+        //! Loads the SPIR-V of \a name, modules with identical code are created once.
+        vk::ShaderModule getShaderModule(const std::string& name);
+        //! Forgets every pipeline created with \a layout, call before destroying it.
+        void evict(vk::PipelineLayout layout);
+
+        size_t getPipelineCount() const;
+        size_t getShaderModuleCount() const;
+
+        //! Serializes every field of \a configInfo that affects the pipeline, pointers are followed rather than compared.
+        static std::string createKey(const PipelineConfigInfo& configInfo, vk::ShaderModule vertModule, vk::ShaderModule fragModule);
+        static uint64_t hashCode(const std::vector<uint32_t>& code);
+
+    private:
+        Device& device;
+        PipelineCompiler& compiler;
+
+        struct ShaderModule {
+            std::vector<uint32_t> code;
+            vk::ShaderModule module;
+        };
+
+        struct Entry {
+            Future future;
+            vk::PipelineLayout layout;
+        };
+
+        mutable std::mutex mutex;
+        //! Keyed by code hash, entries with the same hash are told apart by their code.
+        std::unordered_multimap<uint64_t, ShaderModule> shaderModules;
+        std::unordered_map<std::string, Entry> pipelines;
+        //! Evicted pipelines that may still be compiling with the shared modules.
+        std::vector<Future> evicted;
+    };
+}
@@ -0,0 +1,577 @@
+#include "RenderGraph.hpp"
+#include "Device.hpp"
+
+#include <queue>
+
+using Engine::RenderGraph;
+
+namespace {
+    const vk::AccessFlags WRITE_ACCESS =
+        vk::AccessFlagBits::eColorAttachmentWrite |
+        vk::AccessFlagBits::eDepthStencilAttachmentWrite |
+        vk::AccessFlagBits::eShaderWrite |
+        vk::AccessFlagBits::eTransferWrite |
+        vk::AccessFlagBits::eHostWrite |
+        vk::AccessFlagBits::eMemoryWrite;
+}
+
+void RenderGraph::PassBuilder::read(ResourceId id, Usage usage) {
+    assert(id < graph.resources.size() && "Unknown render graph resource");
+    assert(!(getState(usage).access & WRITE_ACCESS) && "Usage writes the image, declare it with write");
+
+    auto& uses = graph.passes[pass].uses;
+    assert(std::none_of(uses.begin(), uses.end(), [id](const Use& use) { return use.id == id; }) && "Image is used twice by one pass");
+
+    uses.push_back({id, usage, false});
+    graph.resources[id].usage |= getImageUsage(usage);
+}
+
+void RenderGraph::PassBuilder::write(ResourceId id, Usage usage) {
+    assert(id < graph.resources.size() && "Unknown render graph resource");
+
+    auto& uses = graph.passes[pass].uses;
+    assert(std::none_of(uses.begin(), uses.end(), [id](const Use& use) { return use.id == id; }) && "Image is used twice by one pass");
+
+    uses.push_back({id, usage, true});
+    graph.resources[id].usage |= getImageUsage(usage);
+}
+
+void RenderGraph::PassBuilder::setSideEffect() {
+    graph.passes[pass].sideEffect = true;
+}
+
+RenderGraph::RenderGraph(Device& device) : device{device} {
+}
+
+RenderGraph::~RenderGraph() {
+    releaseTransients();
+}
+
+RenderGraph::ResourceId RenderGraph::createImage(const std::string& name, const ImageDesc& desc) {
+    assert(!compiled && "Cannot declare images after the render graph is compiled");
+
+    Resource resource{};
+    resource.name = name;
+    resource.desc = desc;
+    resources.push_back(std::move(resource));
+    return static_cast<ResourceId>(resources.size() - 1);
+}
+
+RenderGraph::ResourceId RenderGraph::importImage(const std::string& name, vk::Image image, vk::ImageView view, vk::Format format,
+                                                 vk::ImageLayout initialLayout, vk::ImageLayout finalLayout, vk::PipelineStageFlags waitStages) {
+    assert(!compiled && "Cannot declare images after the render graph is compiled");
+
+    Resource resource{};
+    resource.name = name;
+    resource.desc.format = format;
+    resource.imported = true;
+    resource.image = image;
+    resource.view = view;
+    resource.finalLayout = finalLayout;
+    resource.state = {initialLayout, waitStages, {}};
+    resources.push_back(std::move(resource));
+    return static_cast<ResourceId>(resources.size() - 1);
+}
+
+void RenderGraph::addPass(const std::string& name, const Setup& setup, Execute execute) {
+    assert(!compiled && "Cannot add passes after the render graph is compiled");
+
+    Pass pass{};
+    pass.name = name;
+    pass.execute = std::move(execute);
+    passes.push_back(std::move(pass));
+
+    PassBuilder builder{*this, static_cast<uint32_t>(passes.size() - 1)};
+    setup(builder);
+}
+
+void RenderGraph::compile() {
+    assert(!compiled && "Render graph is already compiled");
+
+    sortPasses();
+    cullPasses();
+    computeLifetimes();
+
+    std::vector<TransientKey> keys;
+    for (const auto& resource : resources) {
+        if (!resource.imported && resource.firstPass != std::numeric_limits<uint32_t>::max()) {
+            keys.push_back({resource.desc, resource.usage, resource.firstPass, resource.lastPass});
+        }
+    }
+
+    // same images with the same lifetimes as last frame, the placement would come out the same
+    if (keys != transientKeys) {
+        releaseTransients();
+        allocateTransients(keys);
+        transientKeys = std::move(keys);
+    }
+
+    uint32_t index = 0;
+    for (auto& resource : resources) {
+        if (!resource.imported && resource.firstPass != std::numeric_limits<uint32_t>::max()) {
+            const auto& transient = transients[index++];
+            resource.image = transient.image;
+            resource.view = transient.view;
+            resource.slot = transient.slot;
+        }
+    }
+
+    computeBarriers();
+    compiled = true;
+}
+
+void RenderGraph::execute(const vk::CommandBuffer& commandBuffer) {
+    assert(compiled && "Render graph has to be compiled before it is executed");
+
+    for (const auto& pass : passes) {
+        if (pass.culled)
+            continue;
+
+        if (!pass.barriers.empty()) {
+            commandBuffer.pipelineBarrier(
+                pass.srcStages,
+                pass.dstStages,
+                vk::DependencyFlags(),
+                0, nullptr,
+                0, nullptr,
+                static_cast<uint32_t>(pass.barriers.size()), pass.barriers.data());
+        }
+
+        pass.execute(commandBuffer, *this);
+    }
+
+    if (!finalBarriers.empty()) {
+        commandBuffer.pipelineBarrier(
+            finalSrcStages,
+            vk::PipelineStageFlagBits::eBottomOfPipe,
+            vk::DependencyFlags(),
+            0, nullptr,
+            0, nullptr,
+            static_cast<uint32_t>(finalBarriers.size()), finalBarriers.data());
+    }
+}
+
+void RenderGraph::reset() {
+    passes.clear();
+    resources.clear();
+    finalBarriers.clear();
+    finalSrcStages = vk::PipelineStageFlags();
+    compiled = false;
+}
+
+const vk::Image& RenderGraph::getImage(ResourceId id) const {
+    assert(id < resources.size() && "Unknown render graph resource");
+    assert(resources[id].image && "Image is not used by any pass that was kept");
+    return resources[id].image;
+}
+
+const vk::ImageView& RenderGraph::getImageView(ResourceId id) const {
+    assert(id < resources.size() && "Unknown render graph resource");
+    assert(resources[id].view && "Image is not used by any pass that was kept");
+    return resources[id].view;
+}
+
+vk::Format RenderGraph::getFormat(ResourceId id) const {
+    assert(id < resources.size() && "Unknown render graph resource");
+    return resources[id].desc.format;
+}
+
+uint32_t RenderGraph::getCulledPassCount() const {
+    return static_cast<uint32_t>(std::count_if(passes.begin(), passes.end(), [](const Pass& pass) { return pass.culled; }));
+}
+
+vk::DeviceSize RenderGraph::getTransientMemorySize() const {
+    vk::DeviceSize size = 0;
+    for (const auto& slot : slots) {
+        size += slot.size;
+    }
+    return size;
+}
+
+void RenderGraph::sortPasses() {
+    auto passCount = static_cast<uint32_t>(passes.size());
+    std::vector<std::vector<uint32_t>> dependents(passCount);
+    std::vector<uint32_t> dependencies(passCount, 0);
+
+    auto addEdge = [&](uint32_t from, uint32_t to) {
+        if (from == to)
+            return;
+        dependents[from].push_back(to);
+        dependencies[to]++;
+    };
+
+    // uses of every image in declaration order
+    std::vector<std::vector<std::pair<uint32_t, bool>>> imageUses(resources.size());
+    for (uint32_t i = 0; i < passCount; i++) {
+        for (const auto& use : passes[i].uses) {
+            imageUses[use.id].emplace_back(i, use.write);
+        }
+    }
+
+    constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+    for (const auto& uses : imageUses) {
+        uint32_t lastWrite = NONE;
+        for (const auto& [pass, write] : uses) {
+            if (write) {
+                lastWrite = pass;
+            }
+        }
+
+        uint32_t previousWrite = NONE;
+        std::vector<uint32_t> reads;
+        for (const auto& [pass, write] : uses) {
+            if (write) {
+                // write after write, and write after the reads of the previous contents
+                if (previousWrite != NONE) {
+                    addEdge(previousWrite, pass);
+                }
+                for (uint32_t read : reads) {
+                    addEdge(read, pass);
+                }
+                reads.clear();
+                previousWrite = pass;
+            } else if (previousWrite != NONE) {
+                addEdge(previousWrite, pass);
+                reads.push_back(pass);
+            } else if (lastWrite != NONE) {
+                // declared before any writer, it reads the finished image
+                addEdge(lastWrite, pass);
+            }
+        }
+    }
+
+    // Kahn's algorithm, the lowest declaration index goes first so independent passes keep their order
+    std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<>> ready;
+    for (uint32_t i = 0; i < passCount; i++) {
+        if (dependencies[i] == 0) {
+            ready.push(i);
+        }
+    }
+
+    std::vector<uint32_t> order;
+    order.reserve(passCount);
+    while (!ready.empty()) {
+        uint32_t pass = ready.top();
+        ready.pop();
+        order.push_back(pass);
+
+        for (uint32_t dependent : dependents[pass]) {
+            if (--dependencies[dependent] == 0) {
+                ready.push(dependent);
+            }
+        }
+    }
+
+    if (order.size() != passCount) {
+        throw std::runtime_error("render graph passes have a dependency cycle!");
+    }
+
+    std::vector<Pass> sorted;
+    sorted.reserve(passCount);
+    for (uint32_t pass : order) {
+        sorted.push_back(std::move(passes[pass]));
+    }
+    passes = std::move(sorted);
+}
+
+void RenderGraph::cullPasses() {
+    // walk backwards from the imported images, a pass survives if something later needs what it writes
+    std::vector<bool> needed(resources.size(), false);
+    for (size_t i = 0; i < resources.size(); i++) {
+        needed[i] = resources[i].imported;
+    }
+
+    for (size_t i = passes.size(); i-- > 0;) {
+        auto& pass = passes[i];
+        pass.culled = !pass.sideEffect && std::none_of(pass.uses.begin(), pass.uses.end(), [&needed](const Use& use) {
+            return use.write && needed[use.id];
+        });
+
+        if (pass.culled)
+            continue;
+
+        for (const auto& use : pass.uses) {
+            if (!use.write) {
+                needed[use.id] = true;
+            }
+        }
+    }
+}
+
+void RenderGraph::computeLifetimes() {
+    for (uint32_t i = 0; i < passes.size(); i++) {
+        if (passes[i].culled)
+            continue;
+
+        for (const auto& use : passes[i].uses) {
+            auto& resource = resources[use.id];
+            if (resource.firstPass == std::numeric_limits<uint32_t>::max()) {
+                assert((resource.imported || use.write) && "Transient image is read before it is written");
+                resource.firstPass = i;
+            }
+            resource.lastPass = i;
+        }
+    }
+}
+
+void RenderGraph::allocateTransients(const std::vector<TransientKey>& keys) {
+    std::vector<vk::MemoryRequirements> requirements;
+    requirements.reserve(keys.size());
+    transients.reserve(keys.size());
+
+    for (const auto& key : keys) {
+        vk::ImageCreateInfo imageInfo{};
+        imageInfo.imageType = vk::ImageType::e2D;
+        imageInfo.extent = vk::Extent3D{key.desc.extent.width, key.desc.extent.height, 1};
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = key.desc.format;
+        imageInfo.tiling = vk::ImageTiling::eOptimal;
+        imageInfo.initialLayout = vk::ImageLayout::eUndefined;
+        imageInfo.usage = key.usage;
+        imageInfo.samples = vk::SampleCountFlagBits::e1;
+        imageInfo.sharingMode = vk::SharingMode::eExclusive;
+
+        Transient transient{};
+        try {
+            transient.image = device.getLogical().createImage(imageInfo);
+        } catch (vk::SystemError& err) {
+            throw std::runtime_error("failed to create render graph image!");
+        }
+
+        requirements.push_back(device.getLogical().getImageMemoryRequirements(transient.image));
+        transients.push_back(transient);
+    }
+
+    // largest first, every image goes into the first slot whose images all live in other passes
+    std::vector<uint32_t> order(keys.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&requirements](uint32_t a, uint32_t b) {
+        return requirements[a].size > requirements[b].size;
+    });
+
+    std::vector<std::vector<uint32_t>> slotImages;
+    for (uint32_t index : order) {
+        const auto& key = keys[index];
+        const auto& requirement = requirements[index];
+
+        uint32_t slot = 0;
+        for (; slot < slots.size(); slot++) {
+            if (!(slots[slot].memoryTypeBits & requirement.memoryTypeBits))
+                continue;
+
+            bool overlaps = std::any_of(slotImages[slot].begin(), slotImages[slot].end(), [&](uint32_t other) {
+                return keys[other].firstPass <= key.lastPass && key.firstPass <= keys[other].lastPass;
+            });
+            if (!overlaps)
+                break;
+        }
+
+        if (slot == slots.size()) {
+            slots.emplace_back();
+            slotImages.emplace_back();
+        }
+
+        slots[slot].size = std::max(slots[slot].size, requirement.size);
+        slots[slot].memoryTypeBits &= requirement.memoryTypeBits;
+        slotImages[slot].push_back(index);
+        transients[index].slot = slot;
+    }
+
+    for (auto& slot : slots) {
+        vk::MemoryAllocateInfo allocInfo{};
+        allocInfo.allocationSize = slot.size;
+        allocInfo.memoryTypeIndex = device.findMemoryType(slot.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+        try {
+            slot.memory = device.getLogical().allocateMemory(allocInfo);
+        } catch (vk::SystemError& err) {
+            throw std::runtime_error("failed to allocate render graph memory!");
+        }
+    }
+
+    for (size_t i = 0; i < transients.size(); i++) {
+        auto& transient = transients[i];
+        device.getLogical().bindImageMemory(transient.image, slots[transient.slot].memory, 0);
+
+        // views of depth stencil images only see depth, so they can be sampled
+        auto aspect = getAspect(keys[i].desc.format);
+        if (aspect & vk::ImageAspectFlagBits::eDepth) {
+            aspect = vk::ImageAspectFlagBits::eDepth;
+        }
+        transient.view = device.createImageView(transient.image, keys[i].desc.format, aspect);
+    }
+}
+
+void RenderGraph::releaseTransients() {
+    // frames in flight may still use them
+    auto& deletionQueue = device.getDeletionQueue();
+
+    for (const auto& transient : transients) {
+        deletionQueue.push(transient.view);
+        deletionQueue.push(transient.image);
+    }
+    for (const auto& slot : slots) {
+        deletionQueue.push(slot.memory);
+    }
+
+    transients.clear();
+    slots.clear();
+    transientKeys.clear();
+}
+
+void RenderGraph::computeBarriers() {
+    for (uint32_t i = 0; i < passes.size(); i++) {
+        auto& pass = passes[i];
+        pass.barriers.clear();
+        pass.srcStages = vk::PipelineStageFlags();
+        pass.dstStages = vk::PipelineStageFlags();
+
+        if (pass.culled)
+            continue;
+
+        for (const auto& use : pass.uses) {
+            auto& resource = resources[use.id];
+            auto next = getState(use.usage);
+
+            State* state = &resource.state;
+            if (!resource.imported) {
+                state = &slots[resource.slot].state;
+                // a new occupant of the memory starts from undefined contents, but still waits for the previous one
+                if (resource.firstPass == i) {
+                    state->layout = vk::ImageLayout::eUndefined;
+                }
+            }
+
+            vk::ImageMemoryBarrier barrier;
+            if (makeBarrier(resource, *state, next, barrier, pass.srcStages)) {
+                pass.barriers.push_back(barrier);
+                pass.dstStages |= next.stages;
+            }
+        }
+    }
+
+    finalBarriers.clear();
+    finalSrcStages = vk::PipelineStageFlags();
+
+    for (auto& resource : resources) {
+        if (!resource.imported || resource.finalLayout == vk::ImageLayout::eUndefined || resource.finalLayout == resource.state.layout)
+            continue;
+
+        State next{resource.finalLayout, vk::PipelineStageFlagBits::eBottomOfPipe, {}};
+        vk::ImageMemoryBarrier barrier;
+        if (makeBarrier(resource, resource.state, next, barrier, finalSrcStages)) {
+            finalBarriers.push_back(barrier);
+        }
+    }
+}
+
+bool RenderGraph::makeBarrier(const Resource& resource, State& state, const State& next, vk::ImageMemoryBarrier& barrier, vk::PipelineStageFlags& srcStages) {
+    bool previousWrite = static_cast<bool>(state.access & WRITE_ACCESS);
+    bool nextWrite = static_cast<bool>(next.access & WRITE_ACCESS);
+
+    // reads in the same layout run concurrently, a later write waits for all of them
+    if (state.layout == next.layout && !previousWrite && !nextWrite) {
+        state.stages |= next.stages;
+        state.access |= next.access;
+        return false;
+    }
+
+    barrier = vk::ImageMemoryBarrier{};
+    // only writes have to be made available, reads just need the execution dependency
+    barrier.srcAccessMask = state.access & WRITE_ACCESS;
+    barrier.dstAccessMask = next.access;
+    barrier.oldLayout = state.layout;
+    barrier.newLayout = next.layout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = resource.image;
+    barrier.subresourceRange = {getAspect(resource.desc.format), 0, 1, 0, 1};
+
+    if (state.stages) {
+        srcStages |= state.stages;
+    } else {
+        srcStages |= vk::PipelineStageFlagBits::eTopOfPipe;
+    }
+
+    state = next;
+    return true;
+}
+
+RenderGraph::State RenderGraph::getState(Usage usage) {
+    switch (usage) {
+        case Usage::ColorAttachment:
+            return {vk::ImageLayout::eColorAttachmentOptimal,
+                    vk::PipelineStageFlagBits::eColorAttachmentOutput,
+                    vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite};
+        case Usage::DepthAttachment:
+            return {vk::ImageLayout::eDepthStencilAttachmentOptimal,
+                    vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests,
+                    vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite};
+        case Usage::DepthRead:
+            return {vk::ImageLayout::eDepthStencilReadOnlyOptimal,
+                    vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests | vk::PipelineStageFlagBits::eFragmentShader,
+                    vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eShaderRead};
+        case Usage::FragmentSampled:
+            return {vk::ImageLayout::eShaderReadOnlyOptimal,
+                    vk::PipelineStageFlagBits::eFragmentShader,
+                    vk::AccessFlagBits::eShaderRead};
+        case Usage::ComputeSampled:
+            return {vk::ImageLayout::eShaderReadOnlyOptimal,
+                    vk::PipelineStageFlagBits::eComputeShader,
+                    vk::AccessFlagBits::eShaderRead};
+        case Usage::ComputeStorage:
+            return {vk::ImageLayout::eGeneral,
+                    vk::PipelineStageFlagBits::eComputeShader,
+                    vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite};
+        case Usage::TransferSrc:
+            return {vk::ImageLayout::eTransferSrcOptimal,
+                    vk::PipelineStageFlagBits::eTransfer,
+                    vk::AccessFlagBits::eTransferRead};
+        case Usage::TransferDst:
+            return {vk::ImageLayout::eTransferDstOptimal,
+                    vk::PipelineStageFlagBits::eTransfer,
+                    vk::AccessFlagBits::eTransferWrite};
+    }
+
+    throw std::invalid_argument("unsupported render graph usage!");
+}
+
+vk::ImageUsageFlags RenderGraph::getImageUsage(Usage usage) {
+    switch (usage) {
+        case Usage::ColorAttachment:
+            return vk::ImageUsageFlagBits::eColorAttachment;
+        case Usage::DepthAttachment:
+            return vk::ImageUsageFlagBits::eDepthStencilAttachment;
+        case Usage::DepthRead:
+            return vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eSampled;
+        case Usage::FragmentSampled:
+        case Usage::ComputeSampled:
+            return vk::ImageUsageFlagBits::eSampled;
+        case Usage::ComputeStorage:
+            return vk::ImageUsageFlagBits::eStorage;
+        case Usage::TransferSrc:
+            return vk::ImageUsageFlagBits::eTransferSrc;
+        case Usage::TransferDst:
+            return vk::ImageUsageFlagBits::eTransferDst;
+    }
+
+    throw std::invalid_argument("unsupported render graph usage!");
+}
+
+vk::ImageAspectFlags RenderGraph::getAspect(vk::Format format) {
+    switch (format) {
+        case vk::Format::eD16Unorm:
+        case vk::Format::eX8D24UnormPack32:
+        case vk::Format::eD32Sfloat:
+            return vk::ImageAspectFlagBits::eDepth;
+        case vk::Format::eD16UnormS8Uint:
+        case vk::Format::eD24UnormS8Uint:
+        case vk::Format::eD32SfloatS8Uint:
+            return vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil;
+        case vk::Format::eS8Uint:
+            return vk::ImageAspectFlagBits::eStencil;
+        default:
+            return vk::ImageAspectFlagBits::eColor;
+    }
+}
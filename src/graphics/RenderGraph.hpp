@@ -0,0 +1,181 @@
+#pragma once
+
+namespace Engine {
+    class Device;
+
+    /// @brief Frame graph of passes over virtual images
+    /// Passes declare the images they read and write. compile() orders them by those dependencies, culls passes
+    /// whose results are never used, computes the barriers between the remaining ones, batched per pass, and places
+    /// transient images with disjoint lifetimes in the same memory. Writes of an image keep their declaration order,
+    /// a read comes after the last write declared before it, or after the last write at all if none was.
+    /// Independent passes keep their declaration order.
+    /// The graph is rebuilt every frame (reset, declare, compile, execute). Transient images and their memory
+    /// are kept as long as the frames declare the same images with the same lifetimes.
+    /// @link https://www.gdcvault.com/play/1024612/FrameGraph-Extensible-Rendering-Architecture-in
+    class RenderGraph {
+    public:
+        using ResourceId = uint32_t;
+
+        //! How a pass uses an image, decides its layout, stages, access and image usage flags.
+        enum class Usage {
+            ColorAttachment,
+            DepthAttachment,
+            DepthRead,
+            FragmentSampled,
+            ComputeSampled,
+            ComputeStorage,
+            TransferSrc,
+            TransferDst
+        };
+
+        struct ImageDesc {
+            vk::Extent2D extent;
+            vk::Format format;
+
+            bool operator==(const ImageDesc& other) const {
+                return extent == other.extent && format == other.format;
+            }
+        };
+
+        class PassBuilder {
+        public:
+            void read(ResourceId id, Usage usage);
+            void write(ResourceId id, Usage usage);
+            //! Keeps the pass even if nothing reads what it writes.
+            void setSideEffect();
+
+        private:
+            PassBuilder(RenderGraph& graph, uint32_t pass) : graph{graph}, pass{pass} {}
+
+            RenderGraph& graph;
+            uint32_t pass;
+
+            friend class RenderGraph;
+        };
+
+        using Setup = std::function<void(PassBuilder&)>;
+        using Execute = std::function<void(const vk::CommandBuffer&, const RenderGraph&)>;
+
+        explicit RenderGraph(Device& device);
+        ~RenderGraph();
+        RenderGraph(const RenderGraph&) = delete;
+        RenderGraph(RenderGraph&&) = delete;
+        RenderGraph& operator=(const RenderGraph&) = delete;
+        RenderGraph& operator=(RenderGraph&&) = delete;
+
+        //! Image owned by the graph, its contents only live between the first and the last pass using it.
+        ResourceId createImage(const std::string& name, const ImageDesc& desc);
+        //! Image owned by someone else, e.g. the swap chain. It is handed over in \a initialLayout once \a waitStages
+        //! are reached (the semaphore wait stage of a swap chain image) and left in \a finalLayout.
+        ResourceId importImage(const std::string& name, vk::Image image, vk::ImageView view, vk::Format format,
+                               vk::ImageLayout initialLayout, vk::ImageLayout finalLayout,
+                               vk::PipelineStageFlags waitStages = vk::PipelineStageFlagBits::eTopOfPipe);
+        void addPass(const std::string& name, const Setup& setup, Execute execute);
+
+        void compile();
+        void execute(const vk::CommandBuffer& commandBuffer);
+        //! Forgets the passes and images declared for the last frame, transient memory is kept.
+        void reset();
+
+        const vk::Image& getImage(ResourceId id) const;
+        const vk::ImageView& getImageView(ResourceId id) const;
+        vk::Format getFormat(ResourceId id) const;
+
+        uint32_t getPassCount() const { return static_cast<uint32_t>(passes.size()); };
+        uint32_t getCulledPassCount() const;
+        //! Memory of every transient image, after aliasing.
+        vk::DeviceSize getTransientMemorySize() const;
+
+    private:
+        struct State {
+            vk::ImageLayout layout{vk::ImageLayout::eUndefined};
+            vk::PipelineStageFlags stages{};
+            vk::AccessFlags access{};
+        };
+
+        struct Use {
+            ResourceId id;
+            Usage usage;
+            bool write;
+        };
+
+        struct Pass {
+            std::string name;
+            std::vector<Use> uses;
+            Execute execute;
+            bool sideEffect{false};
+            bool culled{false};
+            std::vector<vk::ImageMemoryBarrier> barriers;
+            vk::PipelineStageFlags srcStages{};
+            vk::PipelineStageFlags dstStages{};
+        };
+
+        struct Resource {
+            std::string name;
+            ImageDesc desc;
+            bool imported{false};
+            vk::ImageUsageFlags usage{};
+            vk::Image image;
+            vk::ImageView view;
+            vk::ImageLayout finalLayout{vk::ImageLayout::eUndefined};
+            //! Imported images keep their state here, transient ones in their memory slot.
+            State state;
+            uint32_t firstPass{std::numeric_limits<uint32_t>::max()};
+            uint32_t lastPass{0};
+            uint32_t slot{0};
+        };
+
+        //! Memory shared by transient images with disjoint lifetimes. Its state survives frames,
+        //! so the first pass of a frame waits for the last one of the previous frame.
+        struct Slot {
+            vk::DeviceMemory memory;
+            vk::DeviceSize size{0};
+            uint32_t memoryTypeBits{~0u};
+            State state;
+        };
+
+        //! What the transient images of a frame look like, their images and memory are reused while it matches.
+        struct TransientKey {
+            ImageDesc desc;
+            vk::ImageUsageFlags usage;
+            uint32_t firstPass;
+            uint32_t lastPass;
+
+            bool operator==(const TransientKey& other) const {
+                return desc == other.desc && usage == other.usage && firstPass == other.firstPass && lastPass == other.lastPass;
+            }
+        };
+
+        struct Transient {
+            vk::Image image;
+            vk::ImageView view;
+            uint32_t slot;
+        };
+
+        //! Topological sort of the passes, throws on a dependency cycle.
+        void sortPasses();
+        void cullPasses();
+        void computeLifetimes();
+        void allocateTransients(const std::vector<TransientKey>& keys);
+        void releaseTransients();
+        void computeBarriers();
+
+        //! Moves \a state to \a next, returns false when no barrier is needed.
+        static bool makeBarrier(const Resource& resource, State& state, const State& next, vk::ImageMemoryBarrier& barrier, vk::PipelineStageFlags& srcStages);
+        static State getState(Usage usage);
+        static vk::ImageUsageFlags getImageUsage(Usage usage);
+        static vk::ImageAspectFlags getAspect(vk::Format format);
+
+        Device& device;
+
+        std::vector<Pass> passes;
+        std::vector<Resource> resources;
+        std::vector<vk::ImageMemoryBarrier> finalBarriers;
+        vk::PipelineStageFlags finalSrcStages{};
+
+        std::vector<TransientKey> transientKeys;
+        std::vector<Transient> transients;
+        std::vector<Slot> slots;
+        bool compiled{false};
+    };
+}
@@ -0,0 +1,110 @@
+#include "RenderSettings.hpp"
+
+using Engine::RenderSettings;
+
+RenderSettings RenderSettings::load(const std::string& path) {
+    RenderSettings settings{};
+
+    std::ifstream file{path};
+    if (!file.is_open()) {
+        return settings;
+    }
+
+    auto trim = [](const std::string& s) {
+        auto first = s.find_first_not_of(" \t\r");
+        auto last = s.find_last_not_of(" \t\r");
+        return first == std::string::npos ? std::string{} : s.substr(first, last - first + 1);
+    };
+
+    auto parseBool = [](const std::string& key, const std::string& value) {
+        if (value != "true" && value != "false") {
+            throw std::runtime_error(key + " must be true or false");
+        }
+        return value == "true";
+    };
+
+    std::string line;
+    while (std::getline(file, line)) {
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty())
+            continue;
+
+        auto separator = line.find('=');
+        if (separator == std::string::npos) {
+            throw std::runtime_error("invalid render setting: " + line);
+        }
+
+        auto key = trim(line.substr(0, separator));
+        auto value = trim(line.substr(separator + 1));
+
+        if (key == "frames_in_flight") {
+            auto frames = std::stoul(value);
+            if (frames < 1 || frames > MAX_FRAMES_IN_FLIGHT) {
+                throw std::runtime_error("frames_in_flight must be between 1 and " + std::to_string(MAX_FRAMES_IN_FLIGHT));
+            }
+            settings.framesInFlight = static_cast<uint32_t>(frames);
+        } else if (key == "present_mode") {
+            settings.presentModes.clear();
+            std::stringstream modes{value};
+            std::string mode;
+            while (std::getline(modes, mode, ',')) {
+                settings.presentModes.push_back(parsePresentMode(trim(mode)));
+            }
+        } else if (key == "headless") {
+            settings.headless = parseBool(key, value);
+        } else if (key == "headless_extent") {
+            auto separator = value.find('x');
+            if (separator == std::string::npos) {
+                throw std::runtime_error("headless_extent must be WIDTHxHEIGHT");
+            }
+            auto width = std::stoul(value.substr(0, separator));
+            auto height = std::stoul(value.substr(separator + 1));
+            if (width == 0 || height == 0) {
+                throw std::runtime_error("headless_extent must not be empty");
+            }
+            settings.headlessExtent = vk::Extent2D{static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
+        } else if (key == "headless_frames") {
+            auto frames = std::stoul(value);
+            if (frames < 1) {
+                throw std::runtime_error("headless_frames must be at least 1");
+            }
+            settings.headlessFrames = static_cast<uint32_t>(frames);
+        } else if (key == "readback") {
+            settings.readback = parseBool(key, value);
+        } else if (key == "dynamic_rendering") {
+            settings.dynamicRendering = parseBool(key, value);
+        } else if (key == "gpu_profiler") {
+            settings.gpuProfiler = parseBool(key, value);
+        } else if (key == "gpu_profiler_log_interval") {
+            settings.gpuProfilerLogInterval = std::stof(value);
+            if (settings.gpuProfilerLogInterval < 0) {
+                throw std::runtime_error("gpu_profiler_log_interval must not be negative");
+            }
+        } else if (key == "pipeline_statistics") {
+            settings.pipelineStatistics = parseBool(key, value);
+        } else if (key == "render_stats_log_interval") {
+            settings.renderStatsLogInterval = std::stof(value);
+            if (settings.renderStatsLogInterval < 0) {
+                throw std::runtime_error("render_stats_log_interval must not be negative");
+            }
+        } else {
+            throw std::runtime_error("unknown render setting: " + key);
+        }
+    }
+
+    return settings;
+}
+
+vk::PresentModeKHR RenderSettings::parsePresentMode(const std::string& name) {
+    static const std::unordered_map<std::string, vk::PresentModeKHR> modes {
+        {"immediate", vk::PresentModeKHR::eImmediate},
+        {"mailbox", vk::PresentModeKHR::eMailbox},
+        {"fifo", vk::PresentModeKHR::eFifo},
+        {"fifo_relaxed", vk::PresentModeKHR::eFifoRelaxed}
+    };
+
+    if (auto it = modes.find(name); it != modes.end())
+        return it->second;
+
+    throw std::runtime_error("unknown present mode: " + name);
+}
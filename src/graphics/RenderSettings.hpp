@@ -0,0 +1,39 @@
+#pragma once
+
+namespace Engine {
+    /// @brief Renderer options chosen at startup instead of compile time
+    /// Read from a plain text file of "key = value" lines, '#' starts a comment:
+    ///   frames_in_flight = 1..3
+    ///   present_mode = fifo_relaxed, fifo  (preference order, the first supported one is used)
+    ///   headless = true | false  (renders offscreen without a window or GLFW)
+    ///   headless_extent = WIDTHxHEIGHT  (size of the offscreen images)
+    ///   headless_frames = number of frames a headless run renders before it exits
+    ///   readback = true | false  (headless only, copies every frame to host memory)
+    ///   dynamic_rendering = true | false  (used when the device supports Vulkan 1.3)
+    ///   gpu_profiler = true | false
+    ///   gpu_profiler_log_interval = seconds between reports of the GPU times, 0 never reports
+    ///   pipeline_statistics = true | false  (GPU counters of the render pass, where supported)
+    ///   render_stats_log_interval = seconds between reports of the render stats, 0 never reports
+    /// Missing keys or a missing file keep the defaults.
+    struct RenderSettings {
+        static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 3;
+
+        uint32_t framesInFlight{2};
+        //! FIFO is always supported, so it is used when none of these are.
+        std::vector<vk::PresentModeKHR> presentModes{vk::PresentModeKHR::eMailbox, vk::PresentModeKHR::eImmediate, vk::PresentModeKHR::eFifo};
+        bool headless{false};
+        vk::Extent2D headlessExtent{1280, 720};
+        uint32_t headlessFrames{300};
+        bool readback{false};
+        //! Renders without render pass and framebuffer objects, cleared by the renderer on devices without support.
+        bool dynamicRendering{true};
+        //! Timestamps around the render pass and every renderer system.
+        bool gpuProfiler{true};
+        float gpuProfilerLogInterval{0};
+        bool pipelineStatistics{false};
+        float renderStatsLogInterval{0};
+
+        static RenderSettings load(const std::string& path);
+        static vk::PresentModeKHR parsePresentMode(const std::string& name);
+    };
+}
@@ -0,0 +1,142 @@
+#include "RenderStats.hpp"
+#include "Device.hpp"
+
+#include <iomanip>
+
+using Engine::RenderStats;
+
+RenderStats::Counters& RenderStats::Counters::operator+=(const Counters& other) {
+    draws += other.draws;
+    instances += other.instances;
+    triangles += other.triangles;
+    pipelineBinds += other.pipelineBinds;
+    descriptorBinds += other.descriptorBinds;
+    bufferUploads += other.bufferUploads;
+    return *this;
+}
+
+RenderStats::RenderStats(Device& device, uint32_t frameCount, bool pipelineStatistics) : device{device}, pipelineStatistics{pipelineStatistics} {
+    if (pipelineStatistics && !device.getEnabledFeatures().pipelineStatisticsQuery) {
+        std::cerr << "render stats: pipeline statistics queries are not supported" << std::endl;
+        this->pipelineStatistics = false;
+    }
+
+    transferMark = device.getTransferCount();
+
+    if (!this->pipelineStatistics)
+        return;
+
+    vk::QueryPoolCreateInfo poolInfo{};
+    poolInfo.queryType = vk::QueryType::ePipelineStatistics;
+    poolInfo.queryCount = 1;
+    poolInfo.pipelineStatistics =
+        vk::QueryPipelineStatisticFlagBits::eInputAssemblyPrimitives |
+        vk::QueryPipelineStatisticFlagBits::eVertexShaderInvocations |
+        vk::QueryPipelineStatisticFlagBits::eClippingInvocations |
+        vk::QueryPipelineStatisticFlagBits::eClippingPrimitives |
+        vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations;
+
+    frames.resize(frameCount);
+    for (auto& frame : frames) {
+        try {
+            frame.queryPool = device.getLogical().createQueryPool(poolInfo);
+        } catch (vk::SystemError& err) {
+            throw std::runtime_error("failed to create pipeline statistics query pool!");
+        }
+    }
+}
+
+RenderStats::~RenderStats() {
+    for (const auto& frame : frames) {
+        device.getLogical().destroyQueryPool(frame.queryPool);
+    }
+}
+
+void RenderStats::beginFrame(const vk::CommandBuffer& commandBuffer, uint32_t frameIndex) {
+    lastFrame = std::move(currentFrameCounters);
+    currentFrameCounters.clear();
+
+    auto transfers = device.getTransferCount();
+    lastTransfers = transfers - transferMark;
+    transferMark = transfers;
+
+    if (!pipelineStatistics)
+        return;
+
+    currentFrame = frameIndex;
+    auto& frame = frames[currentFrame];
+
+    if (frame.queried) {
+        std::array<uint64_t, 5> results{};
+        // the timeline value of this frame has been reached, so this does not wait
+        auto result = device.getLogical().getQueryPoolResults(
+            frame.queryPool,
+            0,
+            1,
+            sizeof(results),
+            results.data(),
+            sizeof(results),
+            vk::QueryResultFlagBits::e64);
+
+        if (result == vk::Result::eSuccess) {
+            pipelineCounters = {results[0], results[1], results[2], results[3], results[4]};
+        }
+        frame.queried = false;
+    }
+
+    commandBuffer.resetQueryPool(frame.queryPool, 0, 1);
+}
+
+void RenderStats::beginQuery(const vk::CommandBuffer& commandBuffer) {
+    if (!pipelineStatistics)
+        return;
+
+    commandBuffer.beginQuery(frames[currentFrame].queryPool, 0, vk::QueryControlFlags());
+}
+
+void RenderStats::endQuery(const vk::CommandBuffer& commandBuffer) {
+    if (!pipelineStatistics)
+        return;
+
+    commandBuffer.endQuery(frames[currentFrame].queryPool, 0);
+    frames[currentFrame].queried = true;
+}
+
+void RenderStats::record(const std::string& name, const Counters& counters) {
+    currentFrameCounters[name] += counters;
+}
+
+RenderStats::Counters RenderStats::getTotal() const {
+    Counters total{};
+    for (const auto& [name, counters] : lastFrame) {
+        total += counters;
+    }
+    return total;
+}
+
+void RenderStats::report(std::ostream& out) const {
+    auto line = [&out](const std::string& name, const Counters& counters) {
+        out << std::left << std::setw(16) << name << std::right
+            << std::setw(8) << counters.draws
+            << std::setw(10) << counters.instances
+            << std::setw(12) << counters.triangles
+            << std::setw(10) << counters.pipelineBinds
+            << std::setw(12) << counters.descriptorBinds
+            << std::setw(9) << counters.bufferUploads << std::endl;
+    };
+
+    out << "render stats       draws instances   triangles pipelines descriptors  uploads" << std::endl;
+    for (const auto& [name, counters] : lastFrame) {
+        line(name, counters);
+    }
+    line("total", getTotal());
+    out << "staging transfers: " << lastTransfers << std::endl;
+
+    if (pipelineStatistics) {
+        out << "gpu primitives: " << pipelineCounters.inputAssemblyPrimitives
+            << ", vertex invocations: " << pipelineCounters.vertexInvocations
+            << ", clipping invocations: " << pipelineCounters.clippingInvocations
+            << ", clipping primitives: " << pipelineCounters.clippingPrimitives
+            << ", fragment invocations: " << pipelineCounters.fragmentInvocations << std::endl;
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+namespace Engine {
+    class Device;
+
+    /// @brief Per frame counters of what the renderer systems submitted
+    /// CPU counters are recorded by name for every renderer system and sampled once the frame is complete.
+    /// Optionally a pipeline statistics query around the swap chain render pass counts the work the GPU
+    /// actually did, it is read without waiting when its frame in flight comes around again.
+    class RenderStats {
+    public:
+        struct Counters {
+            uint32_t draws{0};
+            uint32_t instances{0};
+            uint64_t triangles{0};
+            uint32_t pipelineBinds{0};
+            uint32_t descriptorBinds{0};
+            //! Host writes into buffers the GPU reads this frame.
+            uint32_t bufferUploads{0};
+
+            Counters& operator+=(const Counters& other);
+        };
+
+        //! In the order the queried statistics are written by the device.
+        struct PipelineCounters {
+            uint64_t inputAssemblyPrimitives{0};
+            uint64_t vertexInvocations{0};
+            uint64_t clippingInvocations{0};
+            uint64_t clippingPrimitives{0};
+            uint64_t fragmentInvocations{0};
+        };
+
+        //! Pipeline statistics are only queried if \a pipelineStatistics is set and the device supports them.
+        RenderStats(Device& device, uint32_t frameCount, bool pipelineStatistics);
+        ~RenderStats();
+        RenderStats(const RenderStats&) = delete;
+        RenderStats(RenderStats&&) = delete;
+        RenderStats& operator=(const RenderStats&) = delete;
+        RenderStats& operator=(RenderStats&&) = delete;
+
+        //! Completes the counters of the previous frame and resets the query of \a frameIndex, outside of a render pass.
+        void beginFrame(const vk::CommandBuffer& commandBuffer, uint32_t frameIndex);
+        void beginQuery(const vk::CommandBuffer& commandBuffer);
+        void endQuery(const vk::CommandBuffer& commandBuffer);
+        void record(const std::string& name, const Counters& counters);
+
+        //! Counters of every renderer system in the last complete frame.
+        const std::map<std::string, Counters>& getCounters() const { return lastFrame; };
+        Counters getTotal() const;
+        //! Staging transfers to device local memory during the last complete frame.
+        uint64_t getTransferCount() const { return lastTransfers; };
+        bool hasPipelineCounters() const { return pipelineStatistics; };
+        //! Statistics of the latest frame the GPU has finished.
+        const PipelineCounters& getPipelineCounters() const { return pipelineCounters; };
+        void report(std::ostream& out) const;
+
+    private:
+        struct Frame {
+            vk::QueryPool queryPool;
+            bool queried{false};
+        };
+
+        Device& device;
+        bool pipelineStatistics;
+
+        std::vector<Frame> frames;
+        uint32_t currentFrame{0};
+        PipelineCounters pipelineCounters;
+
+        std::map<std::string, Counters> currentFrameCounters;
+        std::map<std::string, Counters> lastFrame;
+        uint64_t transferMark{0};
+        uint64_t lastTransfers{0};
+    };
+}
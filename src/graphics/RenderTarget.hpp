@@ -0,0 +1,35 @@
+#pragma once
+
+namespace Engine {
+    /// @brief Images a frame is rendered into, either the swap chain of a window or offscreen images
+    /// Render passes of every target use the same attachment formats and layout,
+    /// so pipelines built against one of them work with the others.
+    /// With dynamic rendering no render pass or framebuffers are created, frames render into the attachments directly.
+    class RenderTarget {
+    public:
+        struct Attachments {
+            vk::Image colorImage;
+            vk::ImageView colorImageView;
+            vk::Image depthImage;
+            vk::ImageView depthImageView;
+        };
+
+        virtual ~RenderTarget() = default;
+
+        //! Null with dynamic rendering.
+        virtual const vk::RenderPass& getRenderPass() const = 0;
+        virtual const vk::Framebuffer& getFrameBuffer(size_t index) const = 0;
+        virtual Attachments getAttachments(size_t index) const = 0;
+        virtual const vk::Extent2D& getExtent() const = 0;
+        virtual vk::Format getColorFormat() const = 0;
+        virtual vk::Format getDepthFormat() const = 0;
+        //! Layout the color image is left in at the end of a frame.
+        virtual vk::ImageLayout getFinalColorLayout() const = 0;
+
+        //! Waits until the current frame slot is free again and picks the image to render into.
+        virtual vk::Result acquireNextImage(uint32_t& imageIndex) const = 0;
+        //! Records work which has to follow the render passes of the frame, before the command buffer ends.
+        virtual void recordFrameEnd(const vk::CommandBuffer& /*commandBuffer*/, uint32_t /*imageIndex*/) {};
+        virtual vk::Result submitCommandBuffers(const vk::CommandBuffer& buffers, const uint32_t& imageIndex) = 0;
+    };
+}
@@ -2,19 +2,44 @@
 #include "Window.hpp"
 #include "Device.hpp"
 #include "SwapChain.hpp"
+#include "OffscreenTarget.hpp"
+#include "RenderGraph.hpp"
+#include "GpuProfiler.hpp"
+#include "RenderStats.hpp"
 #include "AllocatedBuffer.hpp"
 #include "Descriptors.hpp"
+#include "../Profiler.hpp"
 
 using Engine::Renderer;
+using Engine::SwapChain;
+using Engine::OffscreenTarget;
+using Engine::RenderGraph;
+using Engine::GpuProfiler;
+using Engine::RenderStats;
 using Engine::AllocatedBuffer;
-//using Engine::DescriptorAllocator;
-//using Engine::DescriptorLayoutCache;
+using Engine::DescriptorAllocator;
+using Engine::DescriptorLayoutCache;
 
-Renderer::Renderer(Window& window, Device& device) : window{window}, device{device} {
+Renderer::Renderer(Window& window, Device& device, const RenderSettings& settings) : window{&window}, device{device}, settings{settings} {
+    this->settings.dynamicRendering &= static_cast<bool>(device.getEnabledVulkan13Features().dynamicRendering);
     recreateSwapChain();
+    init();
+}
+
+Renderer::Renderer(Device& device, vk::Extent2D extent, const RenderSettings& settings) : window{nullptr}, device{device}, settings{settings} {
+    assert(device.isHeadless() && "Offscreen rendering needs a headless device");
+    this->settings.dynamicRendering &= static_cast<bool>(device.getEnabledVulkan13Features().dynamicRendering);
+    target = std::make_unique<OffscreenTarget>(device, extent, settings);
+    init();
+}
+
+void Renderer::init() {
     createUniformBuffers();
     createDescriptorSets();
     createCommandBuffers();
+    renderGraph = std::make_unique<RenderGraph>(device);
+    profiler = std::make_unique<GpuProfiler>(device, settings.framesInFlight, settings.gpuProfiler);
+    stats = std::make_unique<RenderStats>(device, settings.framesInFlight, settings.pipelineStatistics);
 }
 
 Renderer::~Renderer() {
@@ -25,7 +50,7 @@ void Renderer::createCommandBuffers() {
     vk::CommandBufferAllocateInfo allocInfo{};
     allocInfo.commandPool = device.getCommandPool();
     allocInfo.level = vk::CommandBufferLevel::ePrimary;
-    allocInfo.commandBufferCount = SwapChain::MAX_FRAMES_IN_FLIGHT;
+    allocInfo.commandBufferCount = settings.framesInFlight;
 
     try {
         commandBuffers = device.getLogical().allocateCommandBuffers(allocInfo);
@@ -35,9 +60,9 @@ void Renderer::createCommandBuffers() {
 }
 
 void Renderer::createUniformBuffers() {
-    uniformBuffers.reserve(SwapChain::MAX_FRAMES_IN_FLIGHT);
+    uniformBuffers.reserve(settings.framesInFlight);
 
-    for (int i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++) {
+    for (uint32_t i = 0; i < settings.framesInFlight; i++) {
         auto buffer = std::make_unique<AllocatedBuffer>(
             device,
             sizeof(UniformBufferObject),
@@ -50,52 +75,60 @@ void Renderer::createUniformBuffers() {
 }
 
 void Renderer::createDescriptorSets() {
-    globalPool = DescriptorPool::Builder(device)
-        .setMaxSets(SwapChain::MAX_FRAMES_IN_FLIGHT)
-        .addPoolSize(vk::DescriptorType::eUniformBuffer, SwapChain::MAX_FRAMES_IN_FLIGHT)
-        .build();
+    layoutCache = std::make_unique<DescriptorLayoutCache>(device);
+    descriptorAllocator = std::make_unique<DescriptorAllocator>(device);
+
+    frameAllocators.reserve(settings.framesInFlight);
+    for (uint32_t i = 0; i < settings.framesInFlight; i++) {
+        frameAllocators.push_back(std::make_unique<DescriptorAllocator>(device));
+    }
 
     globalLayout = DescriptorLayout::Builder(device)
         .addBinding(0, vk::DescriptorType::eUniformBuffer, vk::ShaderStageFlagBits::eVertex)
+        .addTemplateEntry(0, 0)
+        .setCache(*layoutCache)
         .build();
 
-    globalDescriptorSets.reserve(SwapChain::MAX_FRAMES_IN_FLIGHT);
+    globalDescriptorSets.reserve(settings.framesInFlight);
 
-    for (int i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++) {
+    for (uint32_t i = 0; i < settings.framesInFlight; i++) {
         vk::DescriptorSet descriptorSet;
         auto bufferInfo = uniformBuffers[i]->descriptorInfo();
-        DescriptorWriter(*globalLayout, *globalPool)
-            .writeBuffer(0, bufferInfo)
-            .build(descriptorSet);
+        DescriptorWriter(*globalLayout, *descriptorAllocator)
+            .build(descriptorSet, &bufferInfo);
         globalDescriptorSets.push_back(descriptorSet);
     }
 }
 
 void Renderer::recreateSwapChain() {
-    auto extent = vk::Extent2D{static_cast<uint32_t>(window.getWidth()), static_cast<uint32_t>(window.getHeight())};
+    auto extent = vk::Extent2D{static_cast<uint32_t>(window->getWidth()), static_cast<uint32_t>(window->getHeight())};
     while (extent.width == 0 || extent.height == 0) {
-        extent = vk::Extent2D{static_cast<uint32_t>(window.getWidth()), static_cast<uint32_t>(window.getHeight())};
+        extent = vk::Extent2D{static_cast<uint32_t>(window->getWidth()), static_cast<uint32_t>(window->getHeight())};
         glfwWaitEvents();
     }
 
-    device.getLogical().waitIdle();
+    // no wait here, the old swap chain hands its images to the new one and retires the rest through the deletion queue
 
-    if (swapChain == nullptr) {
-        swapChain = std::make_unique<SwapChain>(device, extent);
+    if (target == nullptr) {
+        target = std::make_unique<SwapChain>(device, extent, settings);
     } else {
-        std::shared_ptr<SwapChain> oldSwapChain = std::move(swapChain);
-        swapChain = std::make_unique<SwapChain>(device, extent, oldSwapChain);
+        // with a window the target is always the swap chain
+        std::shared_ptr<SwapChain> oldSwapChain{static_cast<SwapChain*>(target.release())};
+        auto swapChain = std::make_unique<SwapChain>(device, extent, settings, oldSwapChain);
 
         if (!oldSwapChain->compareSwapFormats(*swapChain)) {
             throw std::runtime_error("Swap chain image(or depth) format has changed");
         }
+        target = std::move(swapChain);
     }
 }
 
 uint32_t Renderer::beginFrame() {
+    PROFILE_SCOPE("Renderer::beginFrame");
+
     assert(!isFrameStarted && "Cannot call beginFrame while already in progress");
 
-    auto result = swapChain->acquireNextImage(currentImageIndex);
+    auto result = target->acquireNextImage(currentImageIndex);
 
     if (result == vk::Result::eErrorOutOfDateKHR) {
         recreateSwapChain();
@@ -106,6 +139,10 @@ uint32_t Renderer::beginFrame() {
         throw std::runtime_error("failed to acquire swap chain image");
     }
 
+    // the timeline value of this frame has been reached, nothing reads its transient sets anymore
+    frameAllocators[currentFrameIndex]->resetPools();
+    renderGraph->reset();
+
     isFrameStarted = true;
 
     const auto& commandBuffer = getCurrentCommandBuffer();
@@ -118,31 +155,94 @@ uint32_t Renderer::beginFrame() {
         throw std::runtime_error("failed to begin recording command buffer!");
     }
 
+    profiler->beginFrame(commandBuffer, currentFrameIndex);
+    stats->beginFrame(commandBuffer, currentFrameIndex);
+
     return currentFrameIndex;
 }
 
-void Renderer::beginSwapChainRenderPass(uint32_t frameIndex) {
-    assert(isFrameStarted && "Cannot call beginSwapChainRenderPass if frame is not in progress");
-    assert(frameIndex == currentFrameIndex && "Cannot begin render pass on command buffer from a different frame");
+void Renderer::recordSwapChainRenderPass(uint32_t frameIndex, const std::function<void(const vk::CommandBuffer&)>& record) {
+    assert(isFrameStarted && "Cannot call recordSwapChainRenderPass if frame is not in progress");
+    assert(frameIndex == currentFrameIndex && "Cannot record render pass on command buffer from a different frame");
 
     const auto& commandBuffer = getCurrentCommandBuffer();
 
-    const auto& extent = swapChain->getSwapChainExtent();
-    vk::RenderPassBeginInfo renderPassInfo{};
-    renderPassInfo.renderPass = swapChain->getRenderPass();
-    renderPassInfo.framebuffer = swapChain->getFrameBuffer(currentImageIndex);
-    renderPassInfo.renderArea.offset = vk::Offset2D{ 0, 0 };
-    renderPassInfo.renderArea.extent = extent;
+    auto renderPassScope = profiler->beginScope(commandBuffer, "render pass");
+    stats->beginQuery(commandBuffer);
 
-    std::array<vk::ClearValue, 2> clearValues{};
-    clearValues[0].color = std::array<float, 4>{ 0, 0, 0, 1 };
-    clearValues[1].depthStencil.depth = 1.0f;
-    clearValues[1].depthStencil.stencil = 0;
+    if (settings.dynamicRendering) {
+        recordScenePass(commandBuffer, record);
+    } else {
+        std::array<vk::ClearValue, 2> clearValues{};
+        clearValues[0].color = std::array<float, 4>{ 0, 0, 0, 1 };
+        clearValues[1].depthStencil.depth = 1.0f;
+        clearValues[1].depthStencil.stencil = 0;
+
+        vk::RenderPassBeginInfo renderPassInfo{};
+        renderPassInfo.renderPass = target->getRenderPass();
+        renderPassInfo.framebuffer = target->getFrameBuffer(currentImageIndex);
+        renderPassInfo.renderArea.offset = vk::Offset2D{ 0, 0 };
+        renderPassInfo.renderArea.extent = target->getExtent();
+        renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+        renderPassInfo.pClearValues = clearValues.data();
+
+        commandBuffer.beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
+        setViewport(commandBuffer);
+        record(commandBuffer);
+        commandBuffer.endRenderPass();
+    }
+
+    stats->endQuery(commandBuffer);
+    profiler->endScope(commandBuffer, renderPassScope);
+}
 
-    renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-    renderPassInfo.pClearValues = clearValues.data();
+void Renderer::recordScenePass(const vk::CommandBuffer& commandBuffer, const std::function<void(const vk::CommandBuffer&)>& record) {
+    auto attachments = target->getAttachments(currentImageIndex);
+
+    // the graph does the transitions a render pass would do, the old contents are cleared anyway.
+    // Depth only lives during the frame, so it is a transient image of the graph instead of the target's
+    auto color = renderGraph->importImage("color", attachments.colorImage, attachments.colorImageView, target->getColorFormat(),
+                                          vk::ImageLayout::eUndefined, target->getFinalColorLayout(),
+                                          vk::PipelineStageFlagBits::eColorAttachmentOutput);
+    auto depth = renderGraph->createImage("depth", {target->getExtent(), target->getDepthFormat()});
+
+    renderGraph->addPass("scene", [color, depth](RenderGraph::PassBuilder& builder) {
+        builder.write(color, RenderGraph::Usage::ColorAttachment);
+        builder.write(depth, RenderGraph::Usage::DepthAttachment);
+    }, [this, color, depth, &record](const vk::CommandBuffer& commandBuffer, const RenderGraph& graph) {
+        vk::RenderingAttachmentInfo colorAttachment{};
+        colorAttachment.imageView = graph.getImageView(color);
+        colorAttachment.imageLayout = vk::ImageLayout::eColorAttachmentOptimal;
+        colorAttachment.loadOp = vk::AttachmentLoadOp::eClear;
+        colorAttachment.storeOp = vk::AttachmentStoreOp::eStore;
+        colorAttachment.clearValue.color = std::array<float, 4>{ 0, 0, 0, 1 };
+
+        vk::RenderingAttachmentInfo depthAttachment{};
+        depthAttachment.imageView = graph.getImageView(depth);
+        depthAttachment.imageLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+        depthAttachment.loadOp = vk::AttachmentLoadOp::eClear;
+        depthAttachment.storeOp = vk::AttachmentStoreOp::eDontCare;
+        depthAttachment.clearValue.depthStencil = vk::ClearDepthStencilValue{1.0f, 0};
+
+        vk::RenderingInfo renderingInfo{};
+        renderingInfo.renderArea = vk::Rect2D{{0, 0}, target->getExtent()};
+        renderingInfo.layerCount = 1;
+        renderingInfo.colorAttachmentCount = 1;
+        renderingInfo.pColorAttachments = &colorAttachment;
+        renderingInfo.pDepthAttachment = &depthAttachment;
+
+        commandBuffer.beginRendering(renderingInfo);
+        setViewport(commandBuffer);
+        record(commandBuffer);
+        commandBuffer.endRendering();
+    });
+
+    renderGraph->compile();
+    renderGraph->execute(commandBuffer);
+}
 
-    commandBuffer.beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
+void Renderer::setViewport(const vk::CommandBuffer& commandBuffer) {
+    const auto& extent = target->getExtent();
 
     vk::Viewport viewport{};
     viewport.x = 0;
@@ -157,36 +257,33 @@ void Renderer::beginSwapChainRenderPass(uint32_t frameIndex) {
     commandBuffer.setScissor(0, 1, &scissor);
 }
 
-void Renderer::endSwapChainRenderPass(uint32_t frameIndex) {
-    assert(isFrameStarted && "Cannot call endSwapChainRenderPass if frame is not in progress");
-    assert(frameIndex == currentFrameIndex && "Cannot end render pass on command buffer from a different frame");
-
-    getCurrentCommandBuffer().endRenderPass();
-}
-
 void Renderer::endFrame(uint32_t frameIndex) {
+    PROFILE_SCOPE("Renderer::endFrame");
+
     assert(isFrameStarted && "Cannot call endFrame if frame is not in progress");
     assert(frameIndex == currentFrameIndex && "Cannot end command buffer from a different frame");
 
     const auto& commandBuffer = getCurrentCommandBuffer();
 
+    target->recordFrameEnd(commandBuffer, currentImageIndex);
+
     try {
         commandBuffer.end();
     } catch (vk::SystemError& err) {
         throw std::runtime_error("failed to record command buffer!");
     }
 
-    auto result = swapChain->submitCommandBuffers(commandBuffer, currentImageIndex);
-    if (result == vk::Result::eErrorOutOfDateKHR || result == vk::Result::eSuboptimalKHR || window.wasResized()) {
+    auto result = target->submitCommandBuffers(commandBuffer, currentImageIndex);
+    if (window && (result == vk::Result::eErrorOutOfDateKHR || result == vk::Result::eSuboptimalKHR || window->wasResized())) {
         std::cout << "swap chain out of date/suboptimal/window resized - recreating" << std::endl;
-        window.resetResized();
+        window->resetResized();
         recreateSwapChain();
     } else if (result != vk::Result::eSuccess) {
         throw std::runtime_error("failed to present swap chain image");
     }
 
     isFrameStarted = false;
-    currentFrameIndex = (currentFrameIndex + 1) % SwapChain::MAX_FRAMES_IN_FLIGHT;
+    currentFrameIndex = (currentFrameIndex + 1) % settings.framesInFlight;
 }
 
 const vk::DescriptorSetLayout& Renderer::getGlobalLayoutSet() const {
@@ -194,7 +291,15 @@ const vk::DescriptorSetLayout& Renderer::getGlobalLayoutSet() const {
 }
 
 const vk::RenderPass& Renderer::getSwapChainRenderPass() const {
-    return swapChain->getRenderPass();
+    return target->getRenderPass();
+}
+
+vk::Format Renderer::getColorFormat() const {
+    return target->getColorFormat();
+}
+
+vk::Format Renderer::getDepthFormat() const {
+    return target->getDepthFormat();
 }
 
 bool Renderer::isFrameInProgress() const {
@@ -211,6 +316,11 @@ const std::unique_ptr<AllocatedBuffer>& Renderer::getCurrentUniformBuffer() {
     return uniformBuffers[currentFrameIndex];
 }
 
+DescriptorAllocator& Renderer::getFrameDescriptorAllocator() {
+    assert(isFrameStarted && "Cannot get frame descriptor allocator when frame not in progress");
+    return *frameAllocators[currentFrameIndex];
+}
+
 const vk::DescriptorSet& Renderer::getCurrentDescriptorSet() {
     assert(isFrameStarted && "Cannot get descriptor set when frame not in progress");
     return globalDescriptorSets[currentFrameIndex];
@@ -220,3 +330,9 @@ uint32_t Renderer::getFrameIndex() const {
     assert(isFrameStarted && "Cannot get frame index when frame not in progress");
     return currentFrameIndex;
 }
+
+void Renderer::readFrame(std::vector<uint8_t>& pixels) {
+    assert(isHeadless() && "Frames can only be read back from a headless renderer");
+    assert(!isFrameStarted && "Cannot read a frame back while one is in progress");
+    static_cast<OffscreenTarget&>(*target).readPixels(pixels);
+}
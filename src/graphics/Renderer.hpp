@@ -1,12 +1,18 @@
 #pragma once
 
+#include "RenderSettings.hpp"
+
 namespace Engine {
     class Window;
     class Device;
-    class SwapChain;
+    class RenderTarget;
+    class RenderGraph;
+    class GpuProfiler;
+    class RenderStats;
     class AllocatedBuffer;
-    class DescriptorPool;
     class DescriptorLayout;
+    class DescriptorAllocator;
+    class DescriptorLayoutCache;
 
     struct UniformBufferObject {
         alignas(16) glm::mat4 perspective;
@@ -15,7 +21,9 @@ namespace Engine {
 
     class Renderer {
     public:
-        Renderer(Window& window, Device& device);
+        Renderer(Window& window, Device& device, const RenderSettings& settings);
+        //! Headless renderer drawing into offscreen images of \a extent, the device has to be headless too.
+        Renderer(Device& device, vk::Extent2D extent, const RenderSettings& settings);
         ~Renderer();
         Renderer(const Renderer&) = delete;
         Renderer(Renderer&&) = delete;
@@ -23,33 +31,63 @@ namespace Engine {
         Renderer& operator=(Renderer&&) = delete;
 
         const vk::DescriptorSetLayout& getGlobalLayoutSet() const;
+        //! Null with dynamic rendering, pipelines then take the attachment formats instead.
         const vk::RenderPass& getSwapChainRenderPass() const;
+        vk::Format getColorFormat() const;
+        vk::Format getDepthFormat() const;
         const vk::CommandBuffer& getCurrentCommandBuffer();
         const vk::DescriptorSet& getCurrentDescriptorSet();
         const std::unique_ptr<AllocatedBuffer>& getCurrentUniformBuffer();
+        //! Allocator for sets that live as long as their owner.
+        DescriptorAllocator& getDescriptorAllocator() const { return *descriptorAllocator; }
+        //! Allocator for transient sets, its pools are reset when the frame comes around again.
+        DescriptorAllocator& getFrameDescriptorAllocator();
+        DescriptorLayoutCache& getDescriptorLayoutCache() const { return *layoutCache; }
+        //! Graph of the current frame, it is reset when the frame begins.
+        RenderGraph& getRenderGraph() const { return *renderGraph; }
+        GpuProfiler& getProfiler() const { return *profiler; }
+        RenderStats& getStats() const { return *stats; }
         uint32_t getFrameIndex() const;
+        //! Number of frames recorded ahead of the GPU, per frame resources are sized by it.
+        uint32_t getFramesInFlight() const { return settings.framesInFlight; };
+        const RenderSettings& getSettings() const { return settings; };
         bool isFrameInProgress() const;
+        bool isHeadless() const { return window == nullptr; };
+        //! Copies the last frame into \a pixels as BGRA rows, only headless renderers with readback enabled.
+        void readFrame(std::vector<uint8_t>& pixels);
 
         uint32_t beginFrame();
-        void beginSwapChainRenderPass(uint32_t frameIndex);
-        void endSwapChainRenderPass(uint32_t frameIndex);
+        //! Clears the target and runs \a record inside its render pass. With dynamic rendering this is the "scene" pass
+        //! of the render graph, compiled and executed together with the passes declared on it so far.
+        void recordSwapChainRenderPass(uint32_t frameIndex, const std::function<void(const vk::CommandBuffer&)>& record);
         void endFrame(uint32_t frameIndex);
 
     private:
+        void init();
         void createCommandBuffers();
         void createUniformBuffers();
         void createDescriptorSets();
         void recreateSwapChain();
+        void recordScenePass(const vk::CommandBuffer& commandBuffer, const std::function<void(const vk::CommandBuffer&)>& record);
+        void setViewport(const vk::CommandBuffer& commandBuffer);
 
-        Window& window;
+        Window* window;
         Device& device;
+        RenderSettings settings;
 
-        std::unique_ptr<SwapChain> swapChain;
+        //! Swap chain of the window, or offscreen images when headless.
+        std::unique_ptr<RenderTarget> target;
         std::vector<vk::CommandBuffer, std::allocator<vk::CommandBuffer>> commandBuffers;
         std::vector<std::unique_ptr<AllocatedBuffer>> uniformBuffers;
+        std::unique_ptr<RenderGraph> renderGraph;
+        std::unique_ptr<GpuProfiler> profiler;
+        std::unique_ptr<RenderStats> stats;
+
+        std::unique_ptr<DescriptorLayoutCache> layoutCache;
+        std::unique_ptr<DescriptorAllocator> descriptorAllocator;
+        std::vector<std::unique_ptr<DescriptorAllocator>> frameAllocators;
 
         std::vector<vk::DescriptorSet> globalDescriptorSets;
-        std::unique_ptr<DescriptorPool> globalPool;
         std::unique_ptr<DescriptorLayout> globalLayout;
 
         uint32_t currentImageIndex{0};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "Handle.hpp"
+
+namespace Engine {
+    /// @brief Slot array of resources addressed by generational handles
+    /// Resources are constructed in place, inside blocks of BLOCK_SIZE slots, instead of one heap allocation each.
+    /// Blocks never move, so resources that cannot be moved (meshes, textures) live in the pool directly and
+    /// pointers stay valid until the handle is erased. Released slots are recycled through a free list.
+    template<typename T>
+    class ResourcePool {
+    public:
+        using Resource = T;
+
+        static constexpr uint32_t BLOCK_SIZE = 64;
+
+        ResourcePool() = default;
+        ~ResourcePool() = default;
+        ResourcePool(const ResourcePool&) = delete;
+        ResourcePool(ResourcePool&&) = delete;
+        ResourcePool& operator=(const ResourcePool&) = delete;
+        ResourcePool& operator=(ResourcePool&&) = delete;
+
+        template<typename... Args>
+        Handle<T> emplace(Args&&... args) {
+            uint32_t index;
+            if (freeList.empty()) {
+                index = capacity;
+                if (index % BLOCK_SIZE == 0) {
+                    blocks.push_back(std::make_unique<Block>());
+                }
+                capacity++;
+            } else {
+                index = freeList.back();
+                freeList.pop_back();
+            }
+
+            auto& slot = getSlot(index);
+            try {
+                slot.resource.emplace(std::forward<Args>(args)...);
+            } catch (...) {
+                freeList.push_back(index);
+                throw;
+            }
+            count++;
+            return { index, slot.generation };
+        }
+
+        //! Destroys the resource, \a handle and all its copies become stale.
+        void erase(Handle<T> handle) {
+            if (!contains(handle))
+                return;
+
+            auto& slot = getSlot(handle.index);
+            slot.resource.reset();
+            slot.generation++;
+            freeList.push_back(handle.index);
+            count--;
+        }
+
+        //! Returns nullptr if \a handle is invalid or stale.
+        T* get(Handle<T> handle) const {
+            return contains(handle) ? &*getSlot(handle.index).resource : nullptr;
+        }
+
+        bool contains(Handle<T> handle) const {
+            if (handle.index >= capacity)
+                return false;
+
+            const auto& slot = getSlot(handle.index);
+            return slot.generation == handle.generation && slot.resource.has_value();
+        }
+
+        template<typename Function>
+        void each(Function function) const {
+            for (uint32_t i = 0; i < capacity; ++i) {
+                const auto& slot = getSlot(i);
+                if (slot.resource) {
+                    function(Handle<T>{i, slot.generation}, *slot.resource);
+                }
+            }
+        }
+
+        size_t size() const { return count; };
+        bool empty() const { return count == 0; };
+
+    private:
+        struct Slot {
+            std::optional<T> resource;
+            // starts at 1, so a default constructed handle never matches
+            uint32_t generation{1};
+        };
+
+        using Block = std::array<Slot, BLOCK_SIZE>;
+
+        //! Blocks are owned through pointers, so lookups from const members still reach mutable resources.
+        Slot& getSlot(uint32_t index) const { return (*blocks[index / BLOCK_SIZE])[index % BLOCK_SIZE]; };
+
+        std::vector<std::unique_ptr<Block>> blocks;
+        std::vector<uint32_t> freeList;
+        uint32_t capacity{0};
+        size_t count{0};
+    };
+}
@@ -0,0 +1,58 @@
+#include "Shaders.hpp"
+
+#ifdef ENGINE_EMBED_SHADERS
+#include "EmbeddedShaders.hpp"
+#endif
+
+using Engine::Shaders;
+
+std::vector<uint32_t> Shaders::load(const std::string& name) {
+    size_t size;
+    if (const uint32_t* code = find(name, size))
+        return {code, code + size / sizeof(uint32_t)};
+
+    std::string path = "shaders/" + name + ".spv";
+    // nothing else would notice, a module that does not match the pipeline layout makes every draw invalid
+    if (!std::filesystem::exists(path)) {
+        throw std::runtime_error("shader " + name + " is not embedded and " + path + " is missing, build with glslc or run shaders.sh");
+    }
+
+    return readFile(path);
+}
+
+const uint32_t* Shaders::find(const std::string& name, size_t& size) {
+#ifdef ENGINE_EMBED_SHADERS
+    for (const auto& entry : EmbeddedShaders::entries) {
+        if (name == entry.name) {
+            size = entry.size;
+            return entry.code;
+        }
+    }
+#else
+    (void) name;
+#endif
+    size = 0;
+    return nullptr;
+}
+
+std::vector<uint32_t> Shaders::readFile(const std::string& path) {
+    std::ifstream file {path, std::ios::ate | std::ios::binary};
+
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file: " + path);
+    }
+
+    size_t size = static_cast<size_t>(file.tellg());
+    if (size == 0 || size % sizeof(uint32_t) != 0) {
+        throw std::runtime_error("Invalid SPIR-V file: " + path);
+    }
+
+    std::vector<uint32_t> buffer(size / sizeof(uint32_t));
+
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(buffer.data()), size);
+
+    file.close();
+
+    return buffer;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+namespace Engine {
+    //! Feature switches of the mesh shaders, bit i is the specialization constant with constant_id i.
+    enum ShaderFeatureFlagBits : uint32_t {
+        SHADER_FEATURE_TEXTURED = 1 << 0,
+        SHADER_FEATURE_VERTEX_COLOR = 1 << 1,
+    };
+    using ShaderFeatureFlags = uint32_t;
+
+    /// @brief Access to the SPIR-V of the engine shaders
+    /// Shaders are compiled and embedded into the binary at build time when ENGINE_EMBED_SHADERS is set,
+    /// otherwise the .spv files next to their sources are read from disk. Those are compiled by the build when glslc is found,
+    /// without it the build checks them against the source hash recorded by shaders.sh in a .spv.sha256 file.
+    class Shaders {
+    public:
+        //! Returns the code of \a name, such as "mesh.vert". Throws if it is neither embedded nor found on disk.
+        static std::vector<uint32_t> load(const std::string& name);
+        //! Returns the embedded code of \a name and its size in bytes, nullptr if it was not embedded.
+        static const uint32_t* find(const std::string& name, size_t& size);
+
+        static constexpr uint32_t FEATURE_COUNT = 2;
+
+    private:
+        static std::vector<uint32_t> readFile(const std::string& path);
+    };
+}
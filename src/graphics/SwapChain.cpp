@@ -1,49 +1,98 @@
 #include "SwapChain.hpp"
 #include "Device.hpp"
+#include "../Profiler.hpp"
 
 using Engine::SwapChain;
 
-SwapChain::SwapChain(Device& device, vk::Extent2D windowExtent) : device{device}, windowExtent{windowExtent} {
+SwapChain::SwapChain(Device& device, vk::Extent2D windowExtent, const RenderSettings& settings)
+        : device{device}, windowExtent{windowExtent}, settings{settings}, frameValues(settings.framesInFlight) {
     init();
 }
 
-SwapChain::SwapChain(Device& device, vk::Extent2D windowExtent, std::shared_ptr<SwapChain> previous)
-        : device{device}, windowExtent{windowExtent}, oldSwapChain{std::move(previous)} {
+SwapChain::SwapChain(Device& device, vk::Extent2D windowExtent, const RenderSettings& settings, std::shared_ptr<SwapChain> previous)
+        : device{device}, windowExtent{windowExtent}, settings{settings}, frameValues(settings.framesInFlight), oldSwapChain{std::move(previous)} {
     init();
 
+    // keep pacing against the submissions made through the old swap chain
+    currentFrame = oldSwapChain->currentFrame;
+    frameValues = oldSwapChain->frameValues;
+
+    // earlier presents may still wait on the semaphores of the old swap chain
+    Retired previous{oldSwapChain->swapChain, {}, swapChainImages.size()};
+    previous.semaphores.insert(previous.semaphores.end(), oldSwapChain->renderFinishedSemaphores.begin(), oldSwapChain->renderFinishedSemaphores.end());
+    previous.semaphores.insert(previous.semaphores.end(), oldSwapChain->imageAvailableSemaphores.begin(), oldSwapChain->imageAvailableSemaphores.end());
+    retired = std::move(oldSwapChain->retired);
+    retired.push_back(std::move(previous));
+
+    oldSwapChain->swapChain = nullptr;
+    oldSwapChain->renderFinishedSemaphores.clear();
+    oldSwapChain->imageAvailableSemaphores.clear();
+    oldSwapChain->retired.clear();
     oldSwapChain = nullptr;
 }
 
 SwapChain::~SwapChain() {
-    for (const auto& imageView : swapChainImageViews) {
-        device.getLogical().destroyImageView(imageView);
+    // frames recorded against this swap chain may still be in flight after a resize,
+    // everything goes once the submissions made so far have completed
+    auto& deletionQueue = device.getDeletionQueue();
+
+    for (const auto& framebuffer : swapChainFramebuffers) {
+        deletionQueue.push(framebuffer);
     }
 
-    device.getLogical().destroyImageView(depthImageView);
-    device.getLogical().destroyImage(depthImage);
-    device.getLogical().freeMemory(depthImageMemory);
+    for (const auto& imageView : swapChainImageViews) {
+        deletionQueue.push(imageView);
+    }
 
-    device.getLogical().destroySwapchainKHR(swapChain);
+    deletionQueue.push(depthImageView);
+    deletionQueue.push(depthImage);
+    deletionQueue.push(depthImageMemory);
 
-    for (const auto& framebuffer : swapChainFramebuffers) {
-        device.getLogical().destroyFramebuffer(framebuffer);
+    if (renderPass) {
+        deletionQueue.push(renderPass);
     }
 
-    device.getLogical().destroyRenderPass(renderPass);
+    // empty once a replacing swap chain has taken them over
+    for (const auto& semaphore : renderFinishedSemaphores) {
+        deletionQueue.push(semaphore);
+    }
+    for (const auto& semaphore : imageAvailableSemaphores) {
+        deletionQueue.push(semaphore);
+    }
 
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        device.getLogical().destroySemaphore(renderFinishedSemaphores[i]);
-        device.getLogical().destroySemaphore(imageAvailableSemaphores[i]);
-        device.getLogical().destroyFence(inFlightFences[i]);
+    if (swapChain) {
+        deletionQueue.push(swapChain);
     }
+
+    // without a replacement the device waits for the queues to be idle before it flushes the queue
+    releaseRetired(true);
+}
+
+void SwapChain::releaseRetired(bool all) {
+    auto& deletionQueue = device.getDeletionQueue();
+
+    retired.erase(std::remove_if(retired.begin(), retired.end(), [&](const Retired& entry) {
+        if (!all && entry.presentsLeft > 0)
+            return false;
+
+        // the acquire semaphores may still be waited on by submissions, so the timeline is waited for as well
+        for (const auto& semaphore : entry.semaphores) {
+            deletionQueue.push(semaphore);
+        }
+        deletionQueue.push(entry.swapChain);
+        return true;
+    }), retired.end());
 }
 
 void SwapChain::init() {
     createSwapChain();
     createImageViews();
-    createRenderPass();
     createDepthResources();
-    createFramebuffers();
+    // dynamic rendering uses the image views directly, nothing to rebuild on resize
+    if (!settings.dynamicRendering) {
+        createRenderPass();
+        createFramebuffers();
+    }
     createSyncObjects();
 }
 
@@ -51,7 +100,7 @@ void SwapChain::createSwapChain() {
     SwapChainSupportDetails swapChainSupport = device.getSwapChainSupport();
 
     vk::SurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
-    vk::PresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
+    presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
     vk::Extent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
 
     uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
@@ -115,17 +164,14 @@ vk::SurfaceFormatKHR SwapChain::chooseSwapSurfaceFormat(const std::vector<vk::Su
 }
 
 vk::PresentModeKHR SwapChain::chooseSwapPresentMode(const std::vector<vk::PresentModeKHR>& availablePresentModes) const {
-    vk::PresentModeKHR bestMode = vk::PresentModeKHR::eFifo;
-
-    for (const auto& availablePresentMode : availablePresentModes) {
-        if (availablePresentMode == vk::PresentModeKHR::eMailbox) {
-            return availablePresentMode;
-        } else if (availablePresentMode == vk::PresentModeKHR::eImmediate) {
-            bestMode = availablePresentMode;
+    for (const auto& preferredMode : settings.presentModes) {
+        if (std::find(availablePresentModes.begin(), availablePresentModes.end(), preferredMode) != availablePresentModes.end()) {
+            return preferredMode;
         }
     }
 
-    return bestMode;
+    // the only mode every device has to support
+    return vk::PresentModeKHR::eFifo;
 }
 
 vk::Extent2D SwapChain::chooseSwapExtent(const vk::SurfaceCapabilitiesKHR& capabilities) const {
@@ -185,8 +231,9 @@ void SwapChain::createRenderPass() {
     vk::SubpassDependency dependency{};
     dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
     dependency.dstSubpass = 0;
-    dependency.srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests;
-    dependency.srcAccessMask = vk::AccessFlagBits::eNoneKHR;
+    // the depth image is shared by all frames, so the depth writes of the previous frame have to finish first
+    dependency.srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests;
+    dependency.srcAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentWrite;
     dependency.dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests;
     dependency.dstAccessMask = vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
 
@@ -207,13 +254,14 @@ void SwapChain::createRenderPass() {
 }
 
 void SwapChain::createDepthResources() {
+    // depth is cleared every frame and never stored, tilers can keep it in on-chip memory
     device.createImage(
             swapChainExtent.width,
             swapChainExtent.height,
             swapChainDepthFormat,
             vk::ImageTiling::eOptimal,
-            vk::ImageUsageFlagBits::eDepthStencilAttachment,
-            vk::MemoryPropertyFlagBits::eDeviceLocal,
+            vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eTransientAttachment,
+            vk::MemoryPropertyFlagBits::eDeviceLocal | vk::MemoryPropertyFlagBits::eLazilyAllocated,
             depthImage,
             depthImageMemory);
 
@@ -246,16 +294,13 @@ void SwapChain::createFramebuffers() {
 }
 
 void SwapChain::createSyncObjects() {
-    imageAvailableSemaphores.reserve(MAX_FRAMES_IN_FLIGHT);
-    renderFinishedSemaphores.reserve(MAX_FRAMES_IN_FLIGHT);
-    inFlightFences.reserve(MAX_FRAMES_IN_FLIGHT);
-    imagesInFlight.resize(swapChainImages.size(), nullptr);
+    imageAvailableSemaphores.reserve(settings.framesInFlight);
+    renderFinishedSemaphores.reserve(settings.framesInFlight);
 
     try {
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        for (size_t i = 0; i < settings.framesInFlight; i++) {
             imageAvailableSemaphores.push_back(device.getLogical().createSemaphore({}));
             renderFinishedSemaphores.push_back(device.getLogical().createSemaphore({}));
-            inFlightFences.push_back(device.getLogical().createFence({vk::FenceCreateFlagBits::eSignaled}));
         }
     } catch (vk::SystemError& err) {
         throw std::runtime_error("failed to create synchronization objects for a frame!");
@@ -273,10 +318,12 @@ vk::Format SwapChain::findDepthFormat() const {
 }
 
 vk::Result SwapChain::acquireNextImage(uint32_t& imageIndex) const {
-    auto result = device.getLogical().waitForFences(1, &inFlightFences[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
-    if (result != vk::Result::eSuccess) {
-        throw std::runtime_error("failed to wait for fences");
-    }
+    PROFILE_SCOPE("SwapChain::acquireNextImage");
+
+    device.waitTimeline(frameValues[currentFrame]);
+
+    // anything retired by a submission the GPU has already passed can go, not only this frame slot
+    device.getDeletionQueue().collect(device.getCompletedTimelineValue());
 
     auto nextImageKHR = device.getLogical().acquireNextImageKHR(swapChain, std::numeric_limits<uint64_t>::max(), imageAvailableSemaphores[currentFrame], nullptr);
     imageIndex = nextImageKHR.value;
@@ -284,17 +331,22 @@ vk::Result SwapChain::acquireNextImage(uint32_t& imageIndex) const {
 }
 
 vk::Result SwapChain::submitCommandBuffers(const vk::CommandBuffer& buffers, const uint32_t& imageIndex) {
-    vk::Fence& fence = inFlightFences[currentFrame];
-    vk::Fence* image = imagesInFlight[imageIndex];
-    if (image != nullptr) {
-        auto result = device.getLogical().waitForFences(1, image, VK_TRUE, std::numeric_limits<uint64_t>::max());
-        if (result != vk::Result::eSuccess) {
-            throw std::runtime_error("failed to wait for fences");
-        }
-    }
-    imagesInFlight[imageIndex] = &fence;
+    PROFILE_SCOPE("SwapChain::submitCommandBuffers");
+
+    uint64_t value = device.nextTimelineValue();
+
+    // binary semaphores ignore their values, only the timeline one is read
+    uint64_t waitValues[] = { 0 };
+    uint64_t signalValues[] = { 0, value };
+
+    vk::TimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.waitSemaphoreValueCount = 1;
+    timelineInfo.pWaitSemaphoreValues = waitValues;
+    timelineInfo.signalSemaphoreValueCount = 2;
+    timelineInfo.pSignalSemaphoreValues = signalValues;
 
     vk::SubmitInfo submitInfo{};
+    submitInfo.pNext = &timelineInfo;
 
     vk::Semaphore waitSemaphores[] = { imageAvailableSemaphores[currentFrame] };
     vk::PipelineStageFlags waitStages[] = { vk::PipelineStageFlagBits::eColorAttachmentOutput };
@@ -305,21 +357,19 @@ vk::Result SwapChain::submitCommandBuffers(const vk::CommandBuffer& buffers, con
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &buffers;
 
-    vk::Semaphore signalSemaphores[] = { renderFinishedSemaphores[currentFrame] };
-    submitInfo.signalSemaphoreCount = 1;
+    vk::Semaphore signalSemaphores[] = { renderFinishedSemaphores[currentFrame], device.getTimelineSemaphore() };
+    submitInfo.signalSemaphoreCount = 2;
     submitInfo.pSignalSemaphores = signalSemaphores;
 
-    auto result = device.getLogical().resetFences(1, &fence);
-    if (result != vk::Result::eSuccess) {
-        throw std::runtime_error("failed to reset the fence");
-    }
-
     try {
-        device.getGraphicsQueue().submit(submitInfo, fence);
+        device.getGraphicsQueue().submit(submitInfo, nullptr);
     } catch (vk::SystemError& err) {
         throw std::runtime_error("failed to submit draw command buffer!");
     }
 
+    frameValues[currentFrame] = value;
+    device.getDeletionQueue().retire(value);
+
     vk::PresentInfoKHR presentInfo{};
     presentInfo.waitSemaphoreCount = 1;
     presentInfo.pWaitSemaphores = signalSemaphores;
@@ -330,6 +380,7 @@ vk::Result SwapChain::submitCommandBuffers(const vk::CommandBuffer& buffers, con
     presentInfo.pImageIndices = &imageIndex;
     presentInfo.pResults = nullptr; // Optional
 
+    vk::Result result;
     try {
         result = device.getPresentQueue().presentKHR(presentInfo);
     } catch (vk::OutOfDateKHRError& err) {
@@ -338,7 +389,15 @@ vk::Result SwapChain::submitCommandBuffers(const vk::CommandBuffer& buffers, con
         throw std::runtime_error("failed to present swap chain image!");
     }
 
-    currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    // once every image has been presented again, no present can wait on the semaphores of a replaced swap chain
+    if (!retired.empty() && (result == vk::Result::eSuccess || result == vk::Result::eSuboptimalKHR)) {
+        for (auto& entry : retired) {
+            entry.presentsLeft--;
+        }
+        releaseRetired(false);
+    }
+
+    currentFrame = (currentFrame + 1) % settings.framesInFlight;
 
     return result;
 }
@@ -1,27 +1,35 @@
 #pragma once
 
+#include "RenderTarget.hpp"
+#include "RenderSettings.hpp"
+
 namespace Engine {
     class Device;
 
-    class SwapChain {
+    class SwapChain : public RenderTarget {
     public:
-        SwapChain(Device& device, vk::Extent2D windowExtent);
-        SwapChain(Device& device, vk::Extent2D windowExtent, std::shared_ptr<SwapChain> oldSwapChain);
-        ~SwapChain();
+        SwapChain(Device& device, vk::Extent2D windowExtent, const RenderSettings& settings);
+        SwapChain(Device& device, vk::Extent2D windowExtent, const RenderSettings& settings, std::shared_ptr<SwapChain> oldSwapChain);
+        ~SwapChain() override;
         SwapChain(const SwapChain&) = delete;
         SwapChain(SwapChain&&) = delete;
         SwapChain& operator=(const SwapChain&) = delete;
         SwapChain& operator=(SwapChain&&) = delete;
 
-        const vk::Framebuffer& getFrameBuffer(size_t index) const { return swapChainFramebuffers[index]; };
-        const vk::RenderPass& getRenderPass() const { return renderPass; };
+        const vk::Framebuffer& getFrameBuffer(size_t index) const override { return swapChainFramebuffers[index]; };
+        const vk::RenderPass& getRenderPass() const override { return renderPass; };
         const vk::ImageView& getImageView(size_t index) const { return swapChainImageViews[index]; };
         const vk::Format& getSwapChainImageFormat() const { return swapChainImageFormat; };
-        const vk::Extent2D& getSwapChainExtent() const { return swapChainExtent; };
+        Attachments getAttachments(size_t index) const override { return {swapChainImages[index], swapChainImageViews[index], depthImage, depthImageView}; };
+        const vk::Extent2D& getExtent() const override { return swapChainExtent; };
+        vk::Format getColorFormat() const override { return swapChainImageFormat; };
+        vk::Format getDepthFormat() const override { return swapChainDepthFormat; };
+        vk::ImageLayout getFinalColorLayout() const override { return vk::ImageLayout::ePresentSrcKHR; };
+        vk::PresentModeKHR getPresentMode() const { return presentMode; };
         //size_t imageCount() const { return swapChainImages.size(); };
 
-        vk::Result acquireNextImage(uint32_t& imageIndex) const;
-        vk::Result submitCommandBuffers(const vk::CommandBuffer& buffers, const uint32_t& imageIndex);
+        vk::Result acquireNextImage(uint32_t& imageIndex) const override;
+        vk::Result submitCommandBuffers(const vk::CommandBuffer& buffers, const uint32_t& imageIndex) override;
 
         bool compareSwapFormats(const SwapChain& other) const;
 
@@ -33,11 +41,14 @@ namespace Engine {
         void createDepthResources();
         void createFramebuffers();
         void createSyncObjects();
+        void releaseRetired(bool all);
 
         Device& device;
         vk::Extent2D windowExtent;
+        RenderSettings settings;
         vk::Extent2D swapChainExtent;
         vk::Format swapChainImageFormat;
+        vk::PresentModeKHR presentMode;
         vk::SwapchainKHR swapChain;
         vk::RenderPass renderPass;
 
@@ -46,8 +57,8 @@ namespace Engine {
         std::vector<vk::Framebuffer> swapChainFramebuffers;
         std::vector<vk::Semaphore> imageAvailableSemaphores;
         std::vector<vk::Semaphore> renderFinishedSemaphores;
-        std::vector<vk::Fence> inFlightFences;
-        std::vector<vk::Fence*> imagesInFlight;
+        //! Timeline value signaled by the last submission of each frame slot.
+        std::vector<uint64_t> frameValues;
         uint32_t currentFrame = 0;
 
         vk::Image depthImage;
@@ -57,12 +68,18 @@ namespace Engine {
 
         std::shared_ptr<SwapChain> oldSwapChain;
 
+        //! Semaphores and handle of a replaced swap chain. The timeline does not cover presentation,
+        //! so they are kept until this swap chain has presented as many images as it has.
+        struct Retired {
+            vk::SwapchainKHR swapChain;
+            std::vector<vk::Semaphore> semaphores;
+            size_t presentsLeft;
+        };
+        std::vector<Retired> retired;
+
         vk::Format findDepthFormat() const;
         vk::SurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<vk::SurfaceFormatKHR>& availableFormats) const;
         vk::PresentModeKHR chooseSwapPresentMode(const std::vector<vk::PresentModeKHR>& availablePresentModes) const;
         vk::Extent2D chooseSwapExtent(const vk::SurfaceCapabilitiesKHR& capabilities) const;
-
-    public:
-        static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
     };
 }
@@ -31,10 +31,15 @@ Texture::Texture(Device& device, void* pixels, uint32_t width, uint32_t height,
 }
 
 Texture::~Texture() {
-    device.getLogical().destroySampler(sampler);
-    device.getLogical().destroyImageView(view);
-    device.getLogical().destroyImage(image);
-    device.getLogical().freeMemory(memory);
+    auto& deletionQueue = device.getDeletionQueue();
+    deletionQueue.push(sampler);
+    deletionQueue.push(view);
+    deletionQueue.push(image);
+    deletionQueue.push(memory);
+}
+
+vk::DeviceSize Texture::getMemorySize() const {
+    return static_cast<vk::DeviceSize>(width) * height * componentCount(format);
 }
 
 void Texture::createImage(void* pixels) {
@@ -36,6 +36,7 @@ namespace Engine {
         uint32_t getWidth() const { return width; };
         uint32_t getHeight() const { return height; };
         vk::Format getFormat() const { return format; };
+        vk::DeviceSize getMemorySize() const;
 
     private:
         Device& device;
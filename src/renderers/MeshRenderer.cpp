@@ -2,62 +2,46 @@
 
 #include "../graphics/Device.hpp"
 #include "../graphics/Pipeline.hpp"
+#include "../graphics/PipelineCompiler.hpp"
+#include "../graphics/PipelineLibrary.hpp"
 #include "../graphics/Mesh.hpp"
-#include "../graphics/Texture.hpp"
 #include "../graphics/Renderer.hpp"
-#include "../graphics/Descriptors.hpp"
-#include "../graphics/SwapChain.hpp"
+#include "../graphics/AllocatedBuffer.hpp"
+#include "../graphics/Camera.hpp"
+#include "../graphics/AssetRegistry.hpp"
+#include "../graphics/MaterialTable.hpp"
+#include "../geometry/Frustum.hpp"
+#include "../geometry/Sphere.hpp"
 
 #include "../components/Transform.hpp"
 #include "../components/Model.hpp"
+#include "../components/MeshMaterial.hpp"
 
 using Engine::MeshRenderer;
+using Engine::Mesh;
+using Engine::MaterialTable;
+using Engine::Frustum;
+using Engine::Sphere;
 
-MeshRenderer::MeshRenderer(Device& device, Renderer& renderer) : device{device}, renderer{renderer} {
-    createDescriptorSets();
+MeshRenderer::MeshRenderer(Device& device, Renderer& renderer, PipelineLibrary& pipelineLibrary, AssetRegistry& assets) : device{device}, renderer{renderer}, pipelineLibrary{pipelineLibrary}, assets{assets} {
     createPipelineLayout();
-    createPipeline();
+    // start compiling the default permutation right away
+    getPipeline(SHADER_FEATURE_TEXTURED);
+    createIndirectBuffers();
 }
 
 MeshRenderer::~MeshRenderer() {
+    pipelineLibrary.evict(pipelineLayout);
     device.getLogical().destroyPipelineLayout(pipelineLayout);
 }
 
-void MeshRenderer::createDescriptorSets() {
-    texturePool = DescriptorPool::Builder(device)
-            .setMaxSets(SwapChain::MAX_FRAMES_IN_FLIGHT)
-            .addPoolSize(vk::DescriptorType::eCombinedImageSampler, SwapChain::MAX_FRAMES_IN_FLIGHT)
-            .build();
-
-    textureLayout = DescriptorLayout::Builder(device)
-            .addBinding(0, vk::DescriptorType::eCombinedImageSampler, vk::ShaderStageFlagBits::eFragment)
-            .build();
-
-    textureDescriptorSets.reserve(SwapChain::MAX_FRAMES_IN_FLIGHT);
-
-    texture = std::make_unique<Texture>(device, "textures/texture.jpg", vk::Format::eR8G8B8A8Srgb);
-
-    vk::DescriptorImageInfo imageInfo{};
-    imageInfo.sampler = texture->getSampler();
-    imageInfo.imageView = texture->getView();
-    imageInfo.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
-
-    for (int i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++) {
-        vk::DescriptorSet descriptorSet;
-        DescriptorWriter(*textureLayout, *texturePool)
-                .writeImage(0, imageInfo)
-                .build(descriptorSet);
-        textureDescriptorSets.push_back(descriptorSet);
-    }
-}
-
 void MeshRenderer::createPipelineLayout() {
     vk::PushConstantRange pushConstantRange{};
-    pushConstantRange.stageFlags = vk::ShaderStageFlagBits::eVertex;
+    pushConstantRange.stageFlags = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment;
     pushConstantRange.offset = 0;
     pushConstantRange.size = sizeof(PushConstantData);
 
-    std::array<vk::DescriptorSetLayout, 2> descriptorSetLayouts{renderer.getGlobalLayoutSet(), textureLayout->getDescriptorSetLayout()};
+    std::array<vk::DescriptorSetLayout, 2> descriptorSetLayouts{renderer.getGlobalLayoutSet(), assets.getMaterialTable().getDescriptorSetLayout()};
 
     vk::PipelineLayoutCreateInfo pipelineLayoutInfo{};
     pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
@@ -72,21 +56,49 @@ void MeshRenderer::createPipelineLayout() {
     }
 }
 
-void MeshRenderer::createPipeline() {
-    PipelineConfigInfo configInfo{};
-    Pipeline::defaultPipelineConfigInfo(configInfo);
-    configInfo.pipelineLayout = pipelineLayout;
-    configInfo.renderPass = renderer.getSwapChainRenderPass();
-    configInfo.subpass = 0;
-    pipeline = std::make_unique<Pipeline>(device, "shaders/mesh.vert.spv", "shaders/mesh.frag.spv", configInfo);
+Pipeline* MeshRenderer::getPipeline(ShaderFeatureFlags features) {
+    auto [it, inserted] = pipelines.try_emplace(features);
+    auto& permutation = it->second;
+
+    if (inserted) {
+        auto configInfo = std::make_unique<PipelineConfigInfo>();
+        Pipeline::defaultPipelineConfigInfo(*configInfo);
+        Pipeline::specializeFeatures(*configInfo, features);
+        configInfo->pipelineLayout = pipelineLayout;
+        configInfo->renderPass = renderer.getSwapChainRenderPass();
+        configInfo->subpass = 0;
+        configInfo->colorAttachmentFormat = renderer.getColorFormat();
+        configInfo->depthAttachmentFormat = renderer.getDepthFormat();
+        permutation.pending = pipelineLibrary.getPipeline(std::move(configInfo), "mesh.vert", "mesh.frag");
+    }
+
+    if (!permutation.pipeline) {
+        permutation.pipeline = PipelineCompiler::poll(permutation.pending);
+    }
+    return permutation.pipeline.get();
+}
+
+void MeshRenderer::createIndirectBuffers() {
+    indirectBuffers.reserve(renderer.getFramesInFlight());
+
+    for (uint32_t i = 0; i < renderer.getFramesInFlight(); i++) {
+        auto buffer = std::make_unique<AllocatedBuffer>(
+            device,
+            sizeof(vk::DrawIndexedIndirectCommand),
+            MAX_INDIRECT_COMMANDS,
+            vk::BufferUsageFlagBits::eIndirectBuffer,
+            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+        buffer->map();
+        indirectBuffers.push_back(std::move(buffer));
+    }
 }
 
 void MeshRenderer::render(const FrameInfo& frameInfo) {
     auto& commandBuffer = renderer.getCurrentCommandBuffer();
 
-    pipeline->bind(commandBuffer);
-
-    std::array<vk::DescriptorSet, 2> descriptorSets{renderer.getCurrentDescriptorSet(), textureDescriptorSets[frameInfo.frameIndex]};
+    // one set for every material, draws only change the pushed index
+    const auto& materialTable = frameInfo.assets.getMaterialTable();
+    std::array<vk::DescriptorSet, 2> descriptorSets{renderer.getCurrentDescriptorSet(), materialTable.getDescriptorSet(frameInfo.frameIndex)};
 
     commandBuffer.bindDescriptorSets(
             vk::PipelineBindPoint::eGraphics,
@@ -96,14 +108,87 @@ void MeshRenderer::render(const FrameInfo& frameInfo) {
             descriptorSets.data(),
             0,
             nullptr);
+    stats.descriptorBinds++;
+
+    auto& indirectBuffer = indirectBuffers[frameInfo.frameIndex];
+    auto* commands = static_cast<vk::DrawIndexedIndirectCommand*>(indirectBuffer->getMappedMemory());
+    uint32_t commandCount = 0;
+
+    const auto& viewProjection = frameInfo.camera.getViewProjection();
+    // cotangent of the half vertical field of view
+    float projectionScale = std::abs(frameInfo.camera.getProjection()[1][1]);
+    glm::vec4 cameraPosition{frameInfo.camera.getPosition(), 1};
+
+    const Pipeline* boundPipeline = nullptr;
 
     auto entities = frameInfo.registry.view<const Transform, const Model>();
     for (auto [entity, transform, model] : entities.each()) {
-        PushConstantData push { transform };
-
-        commandBuffer.pushConstants(pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(PushConstantData), &push);
+        const Mesh* mesh = frameInfo.assets.get(model.mesh);
+        if (!mesh)
+            continue;
+
+        // entities are skipped until their permutation is compiled
+        const Pipeline* pipeline = getPipeline(model.features);
+        if (!pipeline)
+            continue;
+
+        if (pipeline != boundPipeline) {
+            pipeline->bind(commandBuffer);
+            boundPipeline = pipeline;
+            stats.pipelineBinds++;
+        }
+
+        const auto* meshMaterial = frameInfo.registry.try_get<MeshMaterial>(entity);
+        uint32_t material = meshMaterial ? materialTable.getIndex(meshMaterial->material) : MaterialTable::DEFAULT_INDEX;
+
+        PushConstantData push { transform, material };
+
+        commandBuffer.pushConstants(pipelineLayout, vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0, sizeof(PushConstantData), &push);
+
+        mesh->bind(commandBuffer);
+
+        // fraction of the viewport height covered by the bounding sphere
+        Sphere sphere = mesh->getBoundingSphere().transformed(*transform);
+        float distance = glm::distance(sphere.getCenter(), glm::vec3{cameraPosition});
+        float screenSize = distance > sphere.getRadius() ? sphere.getRadius() * projectionScale / distance : 1.0f;
+
+        uint32_t lod = mesh->selectLod(screenSize);
+        if (lod > 0) {
+            mesh->drawLod(commandBuffer, lod);
+            stats.draws++;
+            stats.instances++;
+            stats.triangles += mesh->getLod(lod).indexCount / 3;
+            continue;
+        }
+
+        const auto& meshlets = mesh->getMeshlets();
+        if (meshlets.empty() || commandCount + meshlets.size() > MAX_INDIRECT_COMMANDS) {
+            mesh->draw(commandBuffer);
+            stats.draws++;
+            stats.instances++;
+            stats.triangles += mesh->getTriangleCount();
+            continue;
+        }
+
+        // cull in the mesh local space, so meshlet bounds never have to be transformed
+        Frustum frustum{viewProjection * *transform};
+        glm::vec3 localCameraPosition = glm::inverse(*transform) * cameraPosition;
+
+        uint32_t indexCount;
+        uint32_t count = mesh->cullMeshlets(frustum, localCameraPosition, commands + commandCount, MAX_INDIRECT_COMMANDS - commandCount, indexCount);
+        if (count > 0) {
+            mesh->drawIndirect(commandBuffer, indirectBuffer->get(), commandCount * sizeof(vk::DrawIndexedIndirectCommand), count);
+
+            // counted per meshlet command, one API call with multi draw indirect
+            stats.draws += count;
+            stats.instances += count;
+            stats.triangles += indexCount / 3;
+            commandCount += count;
+        }
+    }
 
-        model.mesh->bind(commandBuffer);
-        model.mesh->draw(commandBuffer);
+    // the indirect commands are written straight into mapped memory
+    if (commandCount > 0) {
+        stats.bufferUploads++;
     }
 }
@@ -1,23 +1,26 @@
 #pragma once
 
 #include "RendererSystemBase.hpp"
+#include "../graphics/Shaders.hpp"
 
 namespace Engine {
-    class Texture;
     class Pipeline;
     class Device;
     class FrameInfo;
     class Renderer;
-    class DescriptorPool;
-    class DescriptorLayout;
+    class AllocatedBuffer;
+    class PipelineLibrary;
+    class AssetRegistry;
 
     struct PushConstantData {
         glm::mat4 model{1};
+        //! Index into the material table.
+        uint32_t material{0};
     };
 
     class MeshRenderer : public RendererSystemBase {
     public:
-        MeshRenderer(Device& device, Renderer& renderer);
+        MeshRenderer(Device& device, Renderer& renderer, PipelineLibrary& pipelineLibrary, AssetRegistry& assets);
         ~MeshRenderer() override;
         MeshRenderer(const MeshRenderer&) = delete;
         MeshRenderer(MeshRenderer&&) = delete;
@@ -25,20 +28,28 @@ namespace Engine {
         MeshRenderer& operator=(MeshRenderer&&) = delete;
 
         void render(const FrameInfo& frameInfo) override;
+        const char* getName() const override { return "MeshRenderer"; };
 
     private:
-        void createDescriptorSets();
         void createPipelineLayout();
-        void createPipeline();
+        //! Returns the permutation for \a features, nullptr while it is compiling.
+        Pipeline* getPipeline(ShaderFeatureFlags features);
+        void createIndirectBuffers();
 
         Device& device;
         Renderer& renderer;
-
-        std::vector<vk::DescriptorSet> textureDescriptorSets;
-        std::unique_ptr<DescriptorPool> texturePool;
-        std::unique_ptr<DescriptorLayout> textureLayout;
-        std::unique_ptr<Texture> texture;
-        std::unique_ptr<Pipeline> pipeline;
+        PipelineLibrary& pipelineLibrary;
+        AssetRegistry& assets;
+
+        struct Permutation {
+            //! Null until the background compilation has finished.
+            std::shared_ptr<Pipeline> pipeline;
+            std::shared_future<std::shared_ptr<Pipeline>> pending;
+        };
+        std::unordered_map<ShaderFeatureFlags, Permutation> pipelines;
         vk::PipelineLayout pipelineLayout;
+        std::vector<std::unique_ptr<AllocatedBuffer>> indirectBuffers;
+
+        static constexpr uint32_t MAX_INDIRECT_COMMANDS = 16384;
     };
 }
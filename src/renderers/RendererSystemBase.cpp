@@ -1,13 +1,3 @@
 #include "RendererSystemBase.hpp"
 
 using Engine::RendererSystemBase;
-
-/*size_t RendererSystemBase::drawCalls{};
-size_t RendererSystemBase::totalCalls{};
-size_t RendererSystemBase::totalVertices{};
-
-void RendererSystemBase::clear() {
-    drawCalls = 0;
-    totalCalls = 0;
-    totalVertices = 0;
-}*/
@@ -1,23 +1,31 @@
 #pragma once
 
+#include "../graphics/RenderStats.hpp"
+
 namespace Engine {
     class Camera;
+    class AssetRegistry;
 
     struct FrameInfo {
         uint32_t frameIndex;
         float deltaTime;
         Camera& camera;
         entt::registry& registry;
+        AssetRegistry& assets;
     };
 
 	class RendererSystemBase {
 	public:
         virtual ~RendererSystemBase() = default;
 		virtual void render(const FrameInfo& frameInfo) = 0;
+        //! Label of the system in the GPU profiler and the render stats.
+        virtual const char* getName() const = 0;
+
+        //! What the system submitted since the stats were last reset.
+        const RenderStats::Counters& getStats() const { return stats; };
+        void resetStats() { stats = {}; };
 
-		/*static void clear();
-		static size_t drawCalls;
-		static size_t totalCalls;
-		static size_t totalVertices;*/
+	protected:
+        RenderStats::Counters stats;
 	};
 }
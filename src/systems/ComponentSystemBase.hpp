@@ -13,5 +13,7 @@ namespace Engine {
 	public:
         virtual ~ComponentSystemBase() = default;
 		virtual void update(const SceneInfo& sceneInfo) = 0;
+        //! Label of the system in the CPU profiler.
+        virtual const char* getName() const = 0;
 	};
 }
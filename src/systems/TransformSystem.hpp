@@ -5,5 +5,6 @@
 namespace Engine {
 	class TransformSystem : public ComponentSystemBase {
 		void update(const SceneInfo& sceneInfo) override;
+		const char* getName() const override { return "TransformSystem"; };
 	};
 }